@@ -0,0 +1,225 @@
+// -----------------------------------------------------------------------------
+// adv.c — Advertising interval schedule for the connectable legacy set
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Start the connectable advertising and walk a staged interval schedule:
+//     fast for the first stage after boot or disconnect (quick reconnect), then
+//     stepping down to slower intervals (low average current while nobody
+//     connects). The last stage, or one with duration 0, lasts indefinitely.
+//   • Jump back to the fast stage on a kick (new fault, button press).
+//   • Report the current stage and interval, so reconnect latency can be traded
+//     against current with real numbers.
+//   • Gateway mode: with at least one bonded gateway, a (re)start first sends
+//     high duty cycle directed adverts to the last central (the stack ends them
+//     after 1.28 s with an advertiser timeout), then advertises undirected with
+//     the accept list filtering scan and connection requests, so other phones
+//     neither get scan responses nor connect. A button press opens one fast
+//     stage unfiltered, to pair a new gateway.
+//
+// Concurrency model & safety notes:
+//   • stage_cb() (sleeptimer), adv_kick() and adv_open_pairing() (may be GPIO
+//     IRQ) only set flags and raise SIG_ADV; every stack call happens in adv_process() or
+//     adv_start(), in BLE task context.
+//   • A new interval only applies when advertising is started, so a stage
+//     change restarts the advertiser.
+//
+// -----------------------------------------------------------------------------
+
+#include "adv.h"
+#include "app.h"
+#include "bond.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "sl_bluetooth.h"
+#include "sl_sleeptimer.h"
+#include "nvm3_default.h"
+
+#define ADV_DIRECTED_MS       3u      // high duty directed: <= 3.75 ms
+
+#define ADV_FILTER_FLAGS      (SL_BT_ADVERTISER_USE_FILTER_FOR_SCAN_REQUESTS \
+                               | SL_BT_ADVERTISER_USE_FILTER_FOR_CONNECTION_REQUESTS)
+
+// NVM3 object (application key range): gateway mode on/off
+#define NVM3_KEY_ADV_GATEWAY  0x01200u
+
+// ---- Internal State --------------------------------------------------------------
+// Default: 100 ms for 30 s, 500 ms for 2 min, then 1 s.
+static adv_stage_t s_stages[ADV_MAX_STAGES] = {
+  { 100,  30  },
+  { 500,  120 },
+  { 1000, 0   },
+};
+static uint8_t  s_n = 3;
+
+static uint8_t  s_handle = 0xFF;
+static uint8_t  s_stage = ADV_STAGE_NONE;    // ADV_STAGE_NONE: not advertising
+static volatile bool s_step = false;         // stage duration elapsed
+static volatile bool s_kick = false;         // back to fast requested
+static volatile bool s_pairing = false;      // stage 0 unfiltered (button)
+static bool     s_gateway = false;           // accept list + directed mode
+static sl_sleeptimer_timer_handle_t s_stage_tmr;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static void stage_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+  s_step = true;
+  (void)sl_bt_external_signal(SIG_ADV);
+}
+
+// Filtering only makes sense once a gateway is bonded.
+static bool filtered(void)
+{
+  return s_gateway && !s_pairing && bond_accept_list_count() > 0;
+}
+
+// Apply stage i: new timing, restart the advertiser, arm the stage timer.
+static void enter_stage(uint8_t i)
+{
+  const adv_stage_t *st = &s_stages[i];
+  uint32_t units = (uint32_t)st->interval_ms * 8u / 5u;   // 0.625 ms units
+
+  (void)sl_sleeptimer_stop_timer(&s_stage_tmr);
+  (void)sl_bt_advertiser_stop(s_handle);
+
+  sl_status_t sc = filtered()
+                   ? sl_bt_advertiser_set_configuration(s_handle, ADV_FILTER_FLAGS)
+                   : sl_bt_advertiser_clear_configuration(s_handle, ADV_FILTER_FLAGS);
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_advertiser_set_timing(s_handle, units, units, 0, 0);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_legacy_advertiser_start(s_handle, sl_bt_legacy_advertiser_connectable);
+  }
+  if (sc != SL_STATUS_OK) {
+    LOG_ERROR(BLE, "Advertising stage %u failed sc=0x%04lx\r\n", (unsigned)i, (unsigned long)sc);
+    s_stage = ADV_STAGE_NONE;
+    return;
+  }
+
+  s_stage = i;
+  if (st->duration_s != 0 && i + 1u < s_n) {
+    (void)sl_sleeptimer_start_timer_ms(&s_stage_tmr, (uint32_t)st->duration_s * 1000u,
+                                       stage_cb, NULL, 0, 0);
+  }
+  LOG_INFO(BLE, "Advertising stage %u: %u ms%s\r\n", (unsigned)i, (unsigned)st->interval_ms,
+                filtered() ? ", accept list" : "");
+}
+
+// High duty directed adverts to the last bonded central; false if not possible.
+static bool start_directed(void)
+{
+  bd_addr addr;
+  uint8_t type;
+
+  if (!filtered() || !bond_get_last_central(&addr, &type)) return false;
+
+  (void)sl_sleeptimer_stop_timer(&s_stage_tmr);
+  (void)sl_bt_advertiser_stop(s_handle);
+  sl_status_t sc = sl_bt_legacy_advertiser_start_directed(
+    s_handle, sl_bt_legacy_advertiser_high_duty_directed_connectable, addr, type);
+  if (sc != SL_STATUS_OK) {
+    LOG_ERROR(BLE, "Directed advertising failed sc=0x%04lx\r\n", (unsigned long)sc);
+    return false;
+  }
+  s_stage = ADV_STAGE_DIRECTED;
+  LOG_INFO(BLE, "Advertising directed to the last gateway\r\n");
+  return true;
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void adv_init(uint8_t handle)
+{
+  uint8_t on = 0;
+  s_handle = handle;
+  if (nvm3_readData(nvm3_defaultHandle, NVM3_KEY_ADV_GATEWAY, &on, sizeof(on)) == ECODE_NVM3_OK) {
+    s_gateway = (on != 0);
+  }
+}
+
+void adv_start(void)
+{
+  s_step = false;
+  s_kick = false;
+  s_pairing = false;
+  if (!start_directed()) enter_stage(0);
+}
+
+void adv_timeout(uint8_t handle)
+{
+  // Directed adverts ended without a connection: continue filtered.
+  if (handle == s_handle && s_stage == ADV_STAGE_DIRECTED) enter_stage(0);
+}
+
+void adv_stopped(void)
+{
+  (void)sl_sleeptimer_stop_timer(&s_stage_tmr);
+  s_stage = ADV_STAGE_NONE;
+}
+
+void adv_kick(void)
+{
+  s_kick = true;
+  (void)sl_bt_external_signal(SIG_ADV);
+}
+
+void adv_open_pairing(void)
+{
+  s_pairing = true;
+  adv_kick();
+}
+
+void adv_process(void)
+{
+  bool kick = s_kick, step = s_step;
+  s_kick = false;
+  s_step = false;
+  if (s_stage == ADV_STAGE_NONE) return;   // connected: nothing to schedule
+  // Directed adverts end on their own (adv_timeout); a pairing request waits.
+  if (s_stage == ADV_STAGE_DIRECTED && !s_pairing) return;
+
+  if (kick) {
+    enter_stage(0);   // also restarts the fast window
+  } else if (step && s_stage + 1u < s_n) {
+    if (s_stage == 0) s_pairing = false;   // pairing window over
+    enter_stage((uint8_t)(s_stage + 1u));
+  }
+}
+
+void adv_set_gateway_mode(bool on)
+{
+  uint8_t v = on ? 1u : 0u;
+  s_gateway = on;
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3_KEY_ADV_GATEWAY, &v, sizeof(v));
+  if (s_stage != ADV_STAGE_NONE) adv_start();
+}
+
+bool adv_get_gateway_mode(void) { return s_gateway; }
+
+bool adv_set_schedule(const adv_stage_t *stages, uint8_t n)
+{
+  if (n == 0 || n > ADV_MAX_STAGES) return false;
+  for (uint8_t i = 0; i < n; i++) {
+    if (stages[i].interval_ms < ADV_INTERVAL_MIN_MS
+        || stages[i].interval_ms > ADV_INTERVAL_MAX_MS) {
+      return false;
+    }
+  }
+  for (uint8_t i = 0; i < n; i++) s_stages[i] = stages[i];
+  s_n = n;
+
+  if (s_stage != ADV_STAGE_NONE) enter_stage(0);
+  return true;
+}
+
+uint8_t adv_get_stage(void) { return s_stage; }
+
+uint16_t adv_get_interval_ms(void)
+{
+  if (s_stage == ADV_STAGE_NONE)     return 0;
+  if (s_stage == ADV_STAGE_DIRECTED) return ADV_DIRECTED_MS;
+  return s_stages[s_stage].interval_ms;
+}
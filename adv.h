@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Connectable (legacy) hirdetés lépcsőzetes intervallum ütemezéssel: boot és
+// bontás után gyors, majd fokozatosan lassul; hiba vagy gombnyomás esetén
+// visszaugrik a gyors fokozatra.
+
+#define ADV_MAX_STAGES       4u
+#define ADV_INTERVAL_MIN_MS  20u      // legacy hirdetés korlátai
+#define ADV_INTERVAL_MAX_MS  10240u
+
+// adv_get_stage(): nem hirdet / irányított (high duty) hirdetés az utolsó gateway felé
+#define ADV_STAGE_NONE         0xFFu
+#define ADV_STAGE_DIRECTED     0xFEu
+
+// Egy fokozat: intervallum [ms] (20..10240) és időtartam [s] (0 = marad)
+typedef struct {
+  uint16_t interval_ms;
+  uint16_t duration_s;
+} adv_stage_t;
+
+// A BTHome/scan response adatot az app kezeli, itt csak az időzítés és a start.
+void adv_init(uint8_t handle);
+// Hirdetés (újra)indítása az első fokozattól (boot, kapcsolat bontás)
+void adv_start(void);
+// A stack leállította a hirdetést (kapcsolat nyílt)
+void adv_stopped(void);
+// Vissza a gyors fokozatra (hiba); IRQ-ból is hívható, SIG_ADV jelet küld
+void adv_kick(void);
+// Gomb: gyors fokozat szűrés nélkül (új gateway párosítása), majd újra szűrt
+void adv_open_pairing(void);
+// A stack leállította az irányított hirdetést (advertiser_timeout esemény)
+void adv_timeout(uint8_t handle);
+// Fokozatváltás / kick feldolgozása (BLE task, SIG_ADV jelre)
+void adv_process(void);
+
+// Ütemezés csere; false, ha érvénytelen. Hirdetés közben az első fokozattól indul.
+bool adv_set_schedule(const adv_stage_t *stages, uint8_t n);
+
+// Gateway mód (NVM3-ban megmarad): kötött gateway esetén irányított hirdetés
+// az utolsó central felé, majd accept list szűrésű hirdetés. Ki: mindenki láthatja.
+void adv_set_gateway_mode(bool on);
+bool adv_get_gateway_mode(void);
+
+// Aktuális állapot: fokozat (0xFF = nem hirdet, 0xFE = irányított) és intervallum [ms]
+uint8_t  adv_get_stage(void);
+uint16_t adv_get_interval_ms(void);
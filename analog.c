@@ -0,0 +1,309 @@
+// -----------------------------------------------------------------------------
+// analog.c — Analog front-end (IADC scan + LDMA oversampling)
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Sample the pump driver current (shunt voltage) on IADC0 in scan mode.
+//   • Trigger every scan in hardware from the PWM timer via PRS, so samples are
+//     taken at the same point of every PWM period (middle of the on-time).
+//   • Let LDMA move every scan result into a circular RAM window, so averaging
+//     costs nothing per sample; the window is only summed when read.
+//   • Measure coolant temperature with an NTC divider on the IADC single queue.
+//     Each single conversion is oversampled in the IADC itself (OSR + digital
+//     averaging) and moved by a second self-linked LDMA channel into its own
+//     window. The code -> temperature curve is a const lookup table.
+//
+// Concurrency model & safety notes:
+//   • No IRQs: the LDMA descriptor links to itself and never signals completion.
+//   • Readers sum a window that LDMA may be writing into; a single word write
+//     is atomic, so the worst case is mixing one old and one new sample.
+//
+// Hardware assumptions:
+//   • TIMER0 CC1 is a compare-only channel set up by control.c (pwm_hw_start)
+//     in the middle of the PWM on-time. Its PRS output is the scan trigger.
+//   • SENSE_PIN carries the low-side shunt voltage (SENSE_SHUNT_MOHM) of the
+//     pump driver, referenced to GND.
+//   • NTC_PIN is the midpoint of a VDD - NTC_SERIES_OHM - NTC - GND divider.
+//     The conversion uses VDD as reference, so the result is ratiometric and
+//     independent of the supply voltage.
+//
+// -----------------------------------------------------------------------------
+
+#include "analog.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_iadc.h"
+#include "em_prs.h"
+#include "em_ldma.h"
+#include "dmadrv.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// ---- Pin layout ------------------------------------------------------------------
+// Shunt sense input, single ended against GND. Port B is served by BBUS.
+#define SENSE_PORT        gpioPortB
+#define SENSE_PIN         1   // B1 : I_sense (shunt, low side)
+// Coolant NTC divider midpoint
+#define NTC_PORT          gpioPortB
+#define NTC_PIN           0   // B0 : T_coolant (NTC to GND)
+
+// ---- Conversion parameters -------------------------------------------------------
+// Internal 1.21 V reference with 4x analog gain => ~0.3 V full scale, which
+// gives ~0.74 mA/LSB on a 100 mOhm shunt.
+#define SENSE_VREF_MV     1210u
+#define SENSE_GAIN        4u
+#define SENSE_SHUNT_MOHM  100u
+#define SENSE_CODE_MAX    4095u   // 12-bit right aligned
+
+// NTC: 10k @ 25 °C, B = 3950. s_ntc_lut is generated for these values.
+#define NTC_SERIES_OHM    10000u  // VDD side resistor of the divider
+#define NTC_VREF_MV       3300u   // VDD reference (ratiometric, value only nominal)
+#define NTC_CODE_MIN      16u     // below: shorted NTC
+#define NTC_CODE_MAX      4080u   // above: open NTC
+
+#define IADC_SRC_CLK_HZ   20000000u  // FSRCO prescaled source clock
+#define IADC_ADC_CLK_HZ   10000000u  // conversion clock (normal mode max)
+
+// ---- Oversampling window ---------------------------------------------------------
+// One scan per PWM period (1 kHz); 64 scans => the average covers the last 64 ms.
+#define ANALOG_NUM_CH     1u     // scan table entries, in table order
+#define ANALOG_CH_CURRENT 0u
+#define ANALOG_OVERSAMPLE 64u
+#define ANALOG_WINDOW     (ANALOG_OVERSAMPLE * ANALOG_NUM_CH)
+
+// Single queue (NTC): every conversion is already 32x OSR * 16x averaged in
+// the IADC; the window smooths over the last NTC_WINDOW triggers.
+#define NTC_WINDOW        8u
+
+// Never produced by the IADC (12-bit data), marks "not written yet" slots.
+#define ANALOG_EMPTY      0xFFFFFFFFu
+
+// PRS channel used to route TIMER0 CC1 into the IADC scan trigger
+#define ANALOG_PRS_CH     0
+
+// ---- NTC linearization table ------------------------------------------------------
+// Temperature [0.01 °C] at code = i * 128 (i = 0..32), for the divider above:
+//   R = NTC_SERIES_OHM * code / (4096 - code)
+//   T = 1 / (1/298.15 + ln(R / 10k) / 3950) - 273.15
+// clamped to -40..125 °C. Intermediate codes are interpolated linearly.
+#define NTC_LUT_SHIFT     7u
+static const int16_t s_ntc_lut[33] = {
+   12500,  12500,  10160,   8661,   7633,   6849,   6211,   5669,
+    5196,   4772,   4387,   4030,   3696,   3379,   3077,   2784,
+    2500,   2221,   1945,   1670,   1393,   1113,    825,    528,
+     217,   -114,   -471,   -867,  -1318,  -1859,  -2560,  -3637,
+   -4000,
+};
+
+// ---- Internal State --------------------------------------------------------------
+static volatile uint32_t s_window[ANALOG_WINDOW];
+static LDMA_Descriptor_t s_desc;
+static unsigned int      s_dma_ch;
+static volatile uint32_t s_ntc_window[NTC_WINDOW];
+static LDMA_Descriptor_t s_ntc_desc;
+static unsigned int      s_ntc_dma_ch;
+static bool              s_inited = false;
+static bool              s_running = false;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+// Average of every stride-th word of a window starting at first; false if
+// nothing was captured yet.
+static bool window_average(const volatile uint32_t *win, uint32_t len,
+                           uint32_t first, uint32_t stride, uint32_t *avg)
+{
+  uint32_t sum = 0, n = 0;
+  for (uint32_t i = first; i < len; i += stride) {
+    uint32_t v = win[i];
+    if (v == ANALOG_EMPTY) continue;
+    sum += v & 0xFFFu;
+    n++;
+  }
+  if (n == 0) return false;
+  *avg = (sum + n / 2) / n;
+  return true;
+}
+
+// Start a self-linked (endless) peripheral -> RAM word transfer into win.
+static bool dma_start_window(unsigned int ch, LDMA_Descriptor_t *desc,
+                             LDMA_PeripheralSignal_t signal,
+                             volatile uint32_t *src, volatile uint32_t *win, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) win[i] = ANALOG_EMPTY;
+
+  // Self-linked descriptor: after the last slot LDMA wraps to the first one.
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(signal);
+  *desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, win, len, 0);
+  desc->xfer.size    = ldmaCtrlSizeWord;
+  desc->xfer.doneIfs = 0;
+
+  Ecode_t ec = DMADRV_LdmaStartTransfer((int)ch, &cfg, desc, NULL, NULL);
+  if (ec != ECODE_EMDRV_DMADRV_OK) {
+    LOG_ERROR(CONTROL, "IADC DMA start failed: 0x%lx\r\n", (unsigned long)ec);
+    return false;
+  }
+  return true;
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+// One-time init: IADC scan triggered by PRS, LDMA channel reserved.
+void analog_init(void)
+{
+  if (s_inited) return;
+
+  CMU_ClockEnable(cmuClock_GPIO, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_IADC0, true);
+  CMU_ClockSelectSet(cmuClock_IADCCLK, cmuSelect_FSRCO);
+
+  // Analog bus allocation for the sense pin
+  GPIO_PinModeSet(SENSE_PORT, SENSE_PIN, gpioModeDisabled, 0);
+  GPIO->BBUSALLOC |= (SENSE_PIN & 1u) ? GPIO_BBUSALLOC_BODD0_ADC0
+                                      : GPIO_BBUSALLOC_BEVEN0_ADC0;
+  GPIO_PinModeSet(NTC_PORT, NTC_PIN, gpioModeDisabled, 0);
+  GPIO->BBUSALLOC |= (NTC_PIN & 1u) ? GPIO_BBUSALLOC_BODD0_ADC0
+                                    : GPIO_BBUSALLOC_BEVEN0_ADC0;
+
+  IADC_Init_t init = IADC_INIT_DEFAULT;
+  IADC_AllConfigs_t all = IADC_ALLCONFIGS_DEFAULT;
+  IADC_InitScan_t scan = IADC_INITSCAN_DEFAULT;
+  IADC_ScanTable_t table = IADC_SCANTABLE_DEFAULT;
+  IADC_InitSingle_t single = IADC_INITSINGLE_DEFAULT;
+  IADC_SingleInput_t input = IADC_SINGLEINPUT_DEFAULT;
+
+  // Power up per conversion: a trigger every 1 ms leaves plenty of time.
+  init.warmup = iadcWarmupNormal;
+  init.srcClkPrescale = IADC_calcSrcClkPrescale(IADC0, IADC_SRC_CLK_HZ, 0);
+
+  all.configs[0].reference  = iadcCfgReferenceInt1V2;
+  all.configs[0].vRef       = SENSE_VREF_MV;
+  all.configs[0].analogGain = iadcCfgAnalogGain4x;
+  all.configs[0].osrHighSpeed = iadcCfgOsrHighSpeed2x;
+  all.configs[0].adcClkPrescale =
+    IADC_calcAdcClkPrescale(IADC0, IADC_ADC_CLK_HZ, 0,
+                            iadcCfgModeNormal, init.srcClkPrescale);
+
+  // Config 1: NTC, ratiometric to VDD, oversampled in hardware.
+  all.configs[1].reference    = iadcCfgReferenceVddx;
+  all.configs[1].vRef         = NTC_VREF_MV;
+  all.configs[1].analogGain   = iadcCfgAnalogGain1x;
+  all.configs[1].osrHighSpeed = iadcCfgOsrHighSpeed32x;
+  all.configs[1].digAvg       = iadcDigitalAverage16;
+  all.configs[1].adcClkPrescale =
+    IADC_calcAdcClkPrescale(IADC0, IADC_ADC_CLK_HZ, 0,
+                            iadcCfgModeNormal, init.srcClkPrescale);
+
+  // One scan per PRS edge, every result wakes the LDMA.
+  scan.triggerSelect  = iadcTriggerSelPrs0PosEdge;
+  scan.triggerAction  = iadcTriggerActionOnce;
+  scan.dataValidLevel = iadcFifoCfgDvl1;
+  scan.fifoDmaWakeup  = true;
+  scan.alignment      = iadcAlignRight12;
+  scan.showId         = false;
+  scan.start          = false;
+
+  table.entries[ANALOG_CH_CURRENT].posInput = IADC_portPinToPosInput(SENSE_PORT, SENSE_PIN);
+  table.entries[ANALOG_CH_CURRENT].negInput = iadcNegInputGnd;
+  table.entries[ANALOG_CH_CURRENT].configId = 0;
+  table.entries[ANALOG_CH_CURRENT].includeInScan = true;
+
+  // NTC on the single queue, started by software (analog_temp_trigger()).
+  single.triggerSelect  = iadcTriggerSelImmediate;
+  single.triggerAction  = iadcTriggerActionOnce;
+  single.dataValidLevel = iadcFifoCfgDvl1;
+  single.fifoDmaWakeup  = true;
+  single.alignment      = iadcAlignRight12;
+  single.showId         = false;
+  single.start          = false;
+
+  input.posInput = IADC_portPinToPosInput(NTC_PORT, NTC_PIN);
+  input.negInput = iadcNegInputGnd;
+  input.configId = 1;
+
+  IADC_init(IADC0, &init, &all);
+  IADC_initScan(IADC0, &scan, &table);
+  IADC_initSingle(IADC0, &single, &input);
+
+  // TIMER0 CC1 -> PRS -> IADC scan trigger
+  PRS_ConnectSignal(ANALOG_PRS_CH, prsTypeAsync, prsSignalTIMER0_CC1);
+  PRS_ConnectConsumer(ANALOG_PRS_CH, prsTypeAsync, prsConsumerIADC0_SCANTRIGGER);
+
+  DMADRV_Init();
+  Ecode_t ec = DMADRV_AllocateChannel(&s_dma_ch, NULL);
+  if (ec == ECODE_EMDRV_DMADRV_OK) {
+    ec = DMADRV_AllocateChannel(&s_ntc_dma_ch, NULL);
+  }
+  if (ec != ECODE_EMDRV_DMADRV_OK) {
+    LOG_ERROR(CONTROL, "IADC DMA channel alloc failed: 0x%lx\r\n", (unsigned long)ec);
+    return;
+  }
+
+  // The NTC window runs for the lifetime of the firmware.
+  (void)dma_start_window(s_ntc_dma_ch, &s_ntc_desc, ldmaPeripheralSignal_IADC0_IADC_SINGLE,
+                         &IADC0->SINGLEFIFODATA, s_ntc_window, NTC_WINDOW);
+
+  s_inited = true;
+}
+
+// Arm the scan and start the circular LDMA transfer. Conversions happen only
+// while TIMER0 is running, i.e. while the pump is driven.
+void analog_start(void)
+{
+  if (s_running || !s_inited) return;
+
+  if (!dma_start_window(s_dma_ch, &s_desc, ldmaPeripheralSignal_IADC0_IADC_SCAN,
+                        &IADC0->SCANFIFODATA, s_window, ANALOG_WINDOW)) {
+    return;
+  }
+
+  IADC_command(IADC0, iadcCmdStartScan);
+  s_running = true;
+}
+
+void analog_stop(void)
+{
+  if (!s_running) return;
+  IADC_command(IADC0, iadcCmdStopScan);
+  (void)DMADRV_StopTransfer(s_dma_ch);
+  s_running = false;
+}
+
+// Pump current in mA: I = U_shunt / R_shunt, U_shunt = code * Vref / (max * gain).
+bool analog_get_pump_current_ma(uint16_t *ma)
+{
+  uint32_t code;
+  if (!window_average(s_window, ANALOG_WINDOW, ANALOG_CH_CURRENT, ANALOG_NUM_CH, &code)) {
+    return false;
+  }
+
+  uint32_t uv = (uint32_t)(((uint64_t)code * SENSE_VREF_MV * 1000u)
+                           / (SENSE_CODE_MAX * SENSE_GAIN));
+  uint32_t v  = uv / SENSE_SHUNT_MOHM;
+  *ma = (v > 0xFFFFu) ? 0xFFFFu : (uint16_t)v;
+  return true;
+}
+
+// Start one (hardware oversampled) NTC conversion; LDMA stores the result.
+void analog_temp_trigger(void)
+{
+  if (!s_inited) return;
+  IADC_command(IADC0, iadcCmdStartSingle);
+}
+
+// Coolant temperature in 0.01 °C from the NTC window, via the lookup table.
+bool analog_get_temp_c_x100(int16_t *t)
+{
+  uint32_t code;
+  if (!window_average(s_ntc_window, NTC_WINDOW, 0, 1, &code)) return false;
+  if (code < NTC_CODE_MIN || code > NTC_CODE_MAX) return false;
+
+  uint32_t i    = code >> NTC_LUT_SHIFT;
+  int32_t  frac = (int32_t)(code & ((1u << NTC_LUT_SHIFT) - 1u));
+  int32_t  t0   = s_ntc_lut[i];
+  int32_t  t1   = s_ntc_lut[i + 1];
+  *t = (int16_t)(t0 + (((t1 - t0) * frac) >> NTC_LUT_SHIFT));
+  return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Analóg mérések (IADC scan + LDMA túlmintavételezés), a PWM periódushoz szinkronizálva.
+
+// Init: IADC + PRS + LDMA konfiguráció, mintavétel nélkül
+void analog_init(void);
+
+// Mintavétel indítása/leállítása (a PWM TIMER0 CC1 PRS jele indítja a scan-t)
+void analog_start(void);
+void analog_stop(void);
+
+// Szivattyú áram becslés [mA] (PWM bekapcsolt szakaszában), az utolsó
+// ablak átlaga. false, ha még nincs érvényes minta.
+bool analog_get_pump_current_ma(uint16_t *ma);
+
+// Hűtőfolyadék hőmérséklet (NTC): egy mérés indítása (pl. másodpercenként),
+// és az utolsó mérések átlaga 0.01 °C-ban. false, ha nincs érvényes minta
+// vagy az NTC szakadt/zárlatos.
+void analog_temp_trigger(void);
+bool analog_get_temp_c_x100(int16_t *t);
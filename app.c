@@ -31,9 +31,24 @@
 #include "em_common.h"
 #include "app_assert.h"
 #include "app_log.h"
+#include "loglevel.h"
 #include "sl_bluetooth.h"
 #include "gatt_db.h"
 #include "app.h"
+#include "telemetry.h"
+#include "link.h"
+#include "command.h"
+#include "bthome.h"
+#include "adv.h"
+#include "padv.h"
+#include "bond.h"
+#include "gatt_read.h"
+#include "txpwr.h"
+#include "tlog.h"
+#include "logtx.h"
+#include "trace.h"
+#include "energy.h"
+#include "lowpower.h"
 #include "sl_simple_button_instances.h"
 #include "sl_simple_led_instances.h"
 
@@ -41,6 +56,13 @@
 // The advertising set handle allocated from Bluetooth stack.
 static uint8_t advertising_set_handle = 0xff;
 
+// Largest ATT_MTU offered in the exchange: one 244 byte notification payload
+// fits into a single 251 byte LL data PDU.
+#define STREAM_MAX_MTU        247
+// Sampling period while a client streams telemetry (10 Hz) and otherwise.
+#define STREAM_SAMPLE_MS      100u
+#define IDLE_SAMPLE_MS        1000u
+
 
 // Updates the Pump Enable characteristic.
 sl_status_t update_pump_enable_characteristic(uint8_t data_send);
@@ -52,8 +74,28 @@ sl_status_t send_error_state_notification(uint8_t data_send);
 volatile uint16_t g_flow_x100 = 0;
 volatile uint8_t  g_err = 0;
 
-bool ntf_flow_enabled = false;
-bool ntf_err_enabled  = false;
+// Streaming mode is on (at least one Telemetry Stream subscriber).
+static bool stream_active = false;
+
+// Faults seen at the last sample; a newly raised fault starts a fast burst.
+static uint8_t last_err = 0;
+#define FAULT_BURST_MS        10000u
+
+// Switch between 10 Hz batched streaming and the 1 Hz default, following the
+// Telemetry Stream subscriptions.
+static void stream_update(void)
+{
+  bool on = link_any_subscribed(gattdb_telemetry_stream);
+
+  telemetry_batch_set_payload_max(link_min_mtu(gattdb_telemetry_stream) - 3);
+  if (on == stream_active) {
+    return;
+  }
+  stream_active = on;
+  link_set_demand(LINK_DEMAND_STREAM, on);
+  telemetry_batch_enable(on);
+  hydro_set_sample_period_ms(on ? STREAM_SAMPLE_MS : IDLE_SAMPLE_MS);
+}
 
 uint16_t shared_get_flow_x100(void) {
   CORE_DECLARE_IRQ_STATE;
@@ -79,6 +121,7 @@ uint8_t shared_get_err(void) {
 void shared_set_err(uint8_t v) {
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
+  if (v != g_err) TRACE(TRACE_EV_FAULT, v);
   g_err = v;
   CORE_EXIT_CRITICAL();
 }
@@ -87,9 +130,10 @@ static void hydro_ble_sink(float lpm, uint32_t pulses, uint8_t error_code, void
 {
   (void)user;
 
-  app_log("Flow: %.2f L/min, pulses=%lu, err=%u\r\n",
-                    (double)lpm, (unsigned long)pulses, (unsigned)error_code);
-  return;
+  // Runs per sample in sleeptimer context: tokenized, no formatting here.
+  uint32_t x100 = (uint32_t)(lpm * 100.0f + 0.5f);
+  TLOG("Flow: %lu.%02lu L/min, pulses=%lu, err=%u\r\n",
+       x100 / 100u, x100 % 100u, pulses, error_code);
 }
 
 /**************************************************************************//**
@@ -104,12 +148,27 @@ SL_WEAK void app_init(void)
   // This is called once during start-up.                                    //
   /////////////////////////////////////////////////////////////////////////////
 
+  // Energy mode residency and wakeup sources from here on.
+  energy_init();
+  // Normal power profile until the boot event finds the device idle.
+  lowpower_init();
+
+  // Log output through LDMA from here on; nothing waits for the USART.
+  if (!logtx_init()) {
+    LOG_WARN(POWER, "Async log output not available, VCOM stays blocking\r\n");
+  }
+
+  // Structured events on the SWO trace (tools/swo_trace.py).
+  trace_init();
+  // Tokenized log: reports the measured cost of one TLOG() call.
+  tlog_init();
+
   hydro_init();
   hydro_set_sink(hydro_ble_sink, NULL);   // register debug sink interface
                                           // uses serial terminal
 
-  app_log("handles: flow=%u err=%u\r\n",
-          (unsigned)gattdb_flow_rate, (unsigned)gattdb_send_error);
+  LOG_DEBUG(BLE, "handles: flow=%u err=%u\r\n",
+                 (unsigned)gattdb_flow_rate, (unsigned)gattdb_send_error);
 }
 
 /**************************************************************************//**
@@ -125,6 +184,11 @@ SL_WEAK void app_process_action(void)
   // This is called infinitely.                                              //
   // Do not call blocking functions from here!                               //
   /////////////////////////////////////////////////////////////////////////////
+
+  // Tokenized log records queued by the hot paths go out from here.
+  tlog_process();
+  // Periodic energy mode report (POWER, info).
+  energy_process();
 }
 
 /**************************************************************************//**
@@ -142,60 +206,176 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
     // This event indicates the device has started and the radio is ready.
     // Do not call any stack command before receiving this boot event!
     case sl_bt_evt_system_boot_id:
+      // Offer a large ATT_MTU; the exchange itself happens after connection.
+      {
+        uint16_t max_mtu;
+        sc = sl_bt_gatt_server_set_max_mtu(STREAM_MAX_MTU, &max_mtu);
+        app_log_status_error(sc);
+      }
+
+      // LE Secure Connections bonding; subscriptions persist per bond.
+      bond_init();
+      // Connections run at the level LE Power Control sets, adverts at full power.
+      txpwr_init();
+
       // Create an advertising set.
       sc = sl_bt_advertiser_create_set(&advertising_set_handle);
       app_assert_status(sc);
+      sc = txpwr_advertiser_init(advertising_set_handle);
+      app_log_status_error(sc);
 
-      // Generate data for advertising
-      sc = sl_bt_legacy_advertiser_generate_data(advertising_set_handle,
-                                                 sl_bt_advertiser_general_discoverable);
+      // BTHome telemetry in the advertising data (encrypted with the bind
+      // key), device name in the scan response.
+      if (!bthome_init()) {
+        LOG_WARN(BLE, "BTHome encryption not available\r\n");
+      }
+      sc = set_scan_response_data();
       app_assert_status(sc);
+      sc = update_advertising_data();
+      app_log_status_error(sc);
 
-      // Set advertising interval to 100ms.
-      sc = sl_bt_advertiser_set_timing(
-        advertising_set_handle,
-        160, // min. adv. interval (milliseconds * 1.6)
-        160, // max. adv. interval (milliseconds * 1.6)
-        0,   // adv. duration
-        0);  // max. num. adv. events
-      app_assert_status(sc);
+      // Start advertising and enable connections; the interval follows the
+      // fast-to-slow schedule in adv.c.
+      adv_init(advertising_set_handle);
+      adv_start();
 
-      // Start advertising and enable connections.
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_legacy_advertiser_connectable);
-      app_assert_status(sc);
+      // Full telemetry for synced gateways on a separate periodic train.
+      (void)padv_init();
 
       // Check the pump enable state, then update the characteristic and
       // send notification.
       sc = update_pump_enable_characteristic(0);
       app_log_status_error(sc);
 
-      if (sc == SL_STATUS_OK) {
+      if (sc == SL_STATUS_OK && link_any_subscribed(gattdb_flow_rate)) {
         sc = send_flow_rate_notification(0);
         app_log_status_error(sc);
       }
+
+      // Pump off and nobody subscribed: start in the low-power profile.
+      lowpower_update();
       break;
 
     // -------------------------------
     // This event indicates that a new connection was opened.
     case sl_bt_evt_connection_opened_id:
-      app_log_info("Connection opened.\r\n");
+      LOG_INFO(BLE, "Connection opened.\r\n");
+      link_opened(evt->data.evt_connection_opened.connection);
+      bond_opened(evt->data.evt_connection_opened.connection,
+                  evt->data.evt_connection_opened.bonding);
+      txpwr_opened(evt->data.evt_connection_opened.connection);
+      // The stack stops the connectable advertising on connection.
+      adv_stopped();
+      break;
+
+    // -------------------------------
+    // This event indicates the parameters in use after an update procedure.
+    case sl_bt_evt_connection_parameters_id:
+      link_params_updated(evt->data.evt_connection_parameters.connection,
+                          evt->data.evt_connection_parameters.interval,
+                          evt->data.evt_connection_parameters.latency,
+                          evt->data.evt_connection_parameters.timeout);
+      sc = send_link_params_notification(evt->data.evt_connection_parameters.connection);
+      app_log_status_error(sc);
+      // A bonded client gets its saved subscriptions back once encrypted.
+      if (evt->data.evt_connection_parameters.security_mode != 0
+          && bond_encrypted(evt->data.evt_connection_parameters.connection)) {
+        send_restored_notifications(evt->data.evt_connection_parameters.connection);
+      }
+      // A request rejected while this procedure was running is retried now.
+      link_process();
+      break;
+
+    // -------------------------------
+    // This event indicates that the stack ended advertising on its own
+    // (high duty directed advertising lasts at most 1.28 s).
+    case sl_bt_evt_advertiser_timeout_id:
+      adv_timeout(evt->data.evt_advertiser_timeout.handle);
+      break;
+
+    // -------------------------------
+    // This event indicates that a bonding was created.
+    case sl_bt_evt_sm_bonded_id:
+      bond_bonded(evt->data.evt_sm_bonded.connection, evt->data.evt_sm_bonded.bonding);
+      break;
+
+    // -------------------------------
+    // This event indicates that pairing or bonding failed.
+    case sl_bt_evt_sm_bonding_failed_id:
+      bond_failed(evt->data.evt_sm_bonding_failed.connection,
+                  evt->data.evt_sm_bonding_failed.reason);
+      break;
+
+    // -------------------------------
+    // This event indicates the PHY in use after connecting or an update.
+    case sl_bt_evt_connection_phy_status_id:
+      link_phy_updated(evt->data.evt_connection_phy_status.connection,
+                       evt->data.evt_connection_phy_status.phy);
+      sc = send_link_params_notification(evt->data.evt_connection_phy_status.connection);
+      app_log_status_error(sc);
+      break;
+
+    // -------------------------------
+    // This event indicates the LL data length in use after a change.
+    case sl_bt_evt_connection_data_length_id:
+      link_data_length_updated(evt->data.evt_connection_data_length.connection,
+                               evt->data.evt_connection_data_length.tx_data_len);
+      sc = send_link_params_notification(evt->data.evt_connection_data_length.connection);
+      app_log_status_error(sc);
+      break;
+
+    // -------------------------------
+    // This event indicates a TX power change made by LE Power Control.
+    case sl_bt_evt_connection_tx_power_id:
+      txpwr_level(evt->data.evt_connection_tx_power.connection,
+                  evt->data.evt_connection_tx_power.power_level);
+      break;
+
+    // -------------------------------
+    // This event indicates the result of an RSSI request (TX power warning threshold).
+    case sl_bt_evt_connection_rssi_id:
+      txpwr_rssi(evt->data.evt_connection_rssi.connection,
+                 evt->data.evt_connection_rssi.status,
+                 evt->data.evt_connection_rssi.rssi);
+      break;
+
+    // -------------------------------
+    // This event indicates the ATT_MTU negotiated with the client.
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+      LOG_INFO(BLE, "ATT MTU: %u\r\n", (unsigned)evt->data.evt_gatt_mtu_exchanged.mtu);
+      link_mtu_updated(evt->data.evt_gatt_mtu_exchanged.connection,
+                       evt->data.evt_gatt_mtu_exchanged.mtu);
+      stream_update();
       break;
 
     // -------------------------------
     // This event indicates that a connection was closed.
     case sl_bt_evt_connection_closed_id:
-      app_log_info("Connection closed.\r\n");
+      LOG_INFO(BLE, "Connection closed.\r\n");
+      // Drops every subscription of this connection only.
+      link_closed(evt->data.evt_connection_closed.connection);
+      bond_closed(evt->data.evt_connection_closed.connection);
+      command_connection_closed(evt->data.evt_connection_closed.connection);
+      txpwr_closed(evt->data.evt_connection_closed.connection);
+      stream_update();
+      lowpower_update();
+
+      // Refresh the BTHome data for advertising
+      sc = update_advertising_data();
+      app_log_status_error(sc);
 
-      // Generate data for advertising
-      sc = sl_bt_legacy_advertiser_generate_data(advertising_set_handle,
-                                                 sl_bt_advertiser_general_discoverable);
-      app_assert_status(sc);
+      // Restart advertising after client has disconnected, fast first.
+      adv_start();
+      break;
 
-      // Restart advertising after client has disconnected.
-      sc = sl_bt_legacy_advertiser_start(advertising_set_handle,
-                                         sl_bt_legacy_advertiser_connectable);
-      app_assert_status(sc);
+    // -------------------------------
+    // This event indicates a read of a user type characteristic; the value is
+    // built from live state (also for read blob requests at an offset).
+    case sl_bt_evt_gatt_server_user_read_request_id:
+      gatt_read_request(evt->data.evt_gatt_server_user_read_request.connection,
+                        evt->data.evt_gatt_server_user_read_request.characteristic,
+                        evt->data.evt_gatt_server_user_read_request.att_opcode,
+                        evt->data.evt_gatt_server_user_read_request.offset);
       break;
 
     // -------------------------------
@@ -222,75 +402,142 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
 
         // Toggle LED.
         hydro_enable(data_recv);
-        app_log("Calling hydro_enable with %d\r\n", data_recv);
+        LOG_DEBUG(CONTROL, "Calling hydro_enable with %d\r\n", data_recv);
 
       }
+      // Binary command packet, parsed in place from the event buffer.
+      if (gattdb_command == evt->data.evt_gatt_server_attribute_value.attribute) {
+        command_handle(evt->data.evt_gatt_server_attribute_value.connection,
+                       evt->data.evt_gatt_server_attribute_value.value.data,
+                       evt->data.evt_gatt_server_attribute_value.value.len);
+      }
       break;
 
     // -------------------------------
     // This event occurs when the remote device enabled or disabled the
     // notification.
-    case sl_bt_evt_gatt_server_characteristic_status_id:
-      if (gattdb_flow_rate == evt->data.evt_gatt_server_characteristic_status.characteristic) {
+    case sl_bt_evt_gatt_server_characteristic_status_id: {
+      uint8_t  conn = evt->data.evt_gatt_server_characteristic_status.connection;
+      uint16_t chr  = evt->data.evt_gatt_server_characteristic_status.characteristic;
+      bool     on;
+
+      // Only CCCD writes change subscriptions (not indication confirmations).
+      if (evt->data.evt_gatt_server_characteristic_status.status_flags
+          != sl_bt_gatt_server_client_config) {
+        break;
+      }
+      on = (evt->data.evt_gatt_server_characteristic_status.client_config_flags
+            & sl_bt_gatt_notification) != 0;
+      link_set_subscribed(conn, chr, on);
+      bond_subscriptions_changed(conn);
+      lowpower_update();
+
+      if (gattdb_flow_rate == chr) {
         // A local Client Characteristic Configuration descriptor was changed in
         // the gattdb_flow_rate characteristic.
-        app_log("flow_rate event\r\n");
-        if (evt->data.evt_gatt_server_characteristic_status.client_config_flags
-            & sl_bt_gatt_notification) {
-          // The client just enabled the notification. Send notification of the
-          // current flow rate stored in the local GATT table.
-          app_log("Notification enabled for flow_rate characteristics.\r\n");
-
-          sc = send_flow_rate_notification(0);
-          app_log("Sending initial Flow rate\r\n");
+        LOG_DEBUG(BLE, "Notification %s for flow_rate (conn %u).\r\n",
+                       on ? "enabled" : "disabled", (unsigned)conn);
+        if (on) {
+          // Send the current flow rate to the new subscriber only.
+          uint16_t v = shared_get_flow_x100();
+          sc = link_notify(conn, gattdb_flow_rate, sizeof(v), (const uint8_t *)&v);
           app_log_status_error(sc);
-          ntf_flow_enabled =1;
-
-        } else {
-          app_log("Notification disabled for flow_rate.\r\n");
-          ntf_flow_enabled = 0;
         }
       }
-      if (gattdb_send_error == evt->data.evt_gatt_server_characteristic_status.characteristic){
-                  // A local Client Characteristic Configuration descriptor was changed in
-                          // the gattdb_send_error characteristic.
-                          app_log("send_error event\r\n");
-                          if (evt->data.evt_gatt_server_characteristic_status.client_config_flags
-                              & sl_bt_gatt_notification) {
-                            // The client just enabled the notification. Send notification of the
-                            // current error state stored in the local GATT table.
-                            app_log("Notification enabled for send_error characteristics.\r\n");
-
-                            sc = send_error_state_notification(0);
-                            app_log("Sending initial Error state\r\n");
-                            app_log_status_error(sc);
-                            ntf_err_enabled = 1;
-              } else {
-                  app_log("Notification disabled for send_error.\r\n");
-                            ntf_err_enabled = 0;
-              }
+      if (gattdb_send_error == chr) {
+        // A local Client Characteristic Configuration descriptor was changed in
+        // the gattdb_send_error characteristic.
+        LOG_DEBUG(BLE, "Notification %s for send_error (conn %u).\r\n",
+                       on ? "enabled" : "disabled", (unsigned)conn);
+        if (on) {
+          // Send the current error state to the new subscriber only.
+          uint8_t v = shared_get_err();
+          sc = link_notify(conn, gattdb_send_error, sizeof(v), &v);
+          app_log_status_error(sc);
+        }
       }
-      break;
+      if (gattdb_telemetry == chr) {
+        // A local Client Characteristic Configuration descriptor was changed in
+        // the gattdb_telemetry characteristic.
+        LOG_DEBUG(BLE, "Notification %s for telemetry (conn %u).\r\n",
+                       on ? "enabled" : "disabled", (unsigned)conn);
+        if (on) {
+          // Send the latest sample right away, so the client does not have to
+          // wait a full sampling period.
+          telemetry_sample_t sample;
+          uint8_t buf[TELEMETRY_PACKED_LEN];
+          telemetry_get_latest(&sample);
+          size_t len = telemetry_pack(&sample, buf);
+          sc = link_notify(conn, gattdb_telemetry, len, buf);
+          app_log_status_error(sc);
+        }
+      }
+      if (gattdb_telemetry_stream == chr) {
+        // Streaming runs while at least one connection is subscribed; batches
+        // are sized for the smallest ATT_MTU among the subscribers.
+        LOG_DEBUG(BLE, "Notification %s for telemetry stream (conn %u).\r\n",
+                       on ? "enabled" : "disabled", (unsigned)conn);
+        stream_update();
+      }
+    } break;
 
     ///////////////////////////////////////////////////////////////////////////
     // Add additional event handlers here as your application requires!      //
     ///////////////////////////////////////////////////////////////////////////
     case sl_bt_evt_system_external_signal_id: {
-          app_log("External sig arrived\r\n");
           uint32_t sig = evt->data.evt_system_external_signal.extsignals;
           if (sig & SIG_SAMPLE) {
-            uint16_t flow = shared_get_flow_x100();
-            uint8_t  err  = shared_get_err();
-            app_log("ntf_flow_enable: %d   ntf_err_enable: %d\r\n",ntf_flow_enabled, ntf_err_enabled);
-            if (ntf_flow_enabled) {
-                sl_status_t sc = send_flow_rate_notification(flow);
-              if (sc) app_log("notify flow sc=%lu (0x%04lx)\r\n",(unsigned long)sc,(unsigned long)sc);
+            uint8_t err = shared_get_err();
+            if (err & ~last_err) {
+              link_burst(FAULT_BURST_MS);
+              adv_kick();
+            }
+            last_err = err;
+
+            // Passive scanners get every changed sample from the advertising data.
+            sl_status_t sc = update_advertising_data();
+            if (sc) TLOG("adv data sc=0x%04lx\r\n", sc);
+            if (padv_is_active()) {
+              telemetry_sample_t sample;
+              telemetry_get_latest(&sample);
+              sl_status_t sc = padv_update(&sample);
+              if (sc) TLOG("periodic adv sc=0x%04lx\r\n", sc);
+            }
+            // One packed notification per sample for telemetry clients; the
+            // legacy characteristics are only touched if someone listens.
+            if (link_any_subscribed(gattdb_telemetry)) {
+              sl_status_t sc = send_telemetry_notification();
+              if (sc) TLOG("notify telemetry sc=0x%04lx\r\n", sc);
+            }
+            if (link_any_subscribed(gattdb_flow_rate)) {
+                sl_status_t sc = send_flow_rate_notification(shared_get_flow_x100());
+              if (sc) TLOG("notify flow sc=0x%04lx\r\n", sc);
             }
-            if (ntf_err_enabled) {
-              sl_status_t sc = send_error_state_notification(err);
-              if (sc) app_log("notify err sc=%lu (0x%04lx)\r\n",(unsigned long)sc,(unsigned long)sc);
+            if (link_any_subscribed(gattdb_send_error)) {
+              sl_status_t sc = send_error_state_notification(shared_get_err());
+              if (sc) TLOG("notify err sc=0x%04lx\r\n", sc);
             }
           }
+          if (sig & SIG_LINK) {
+            link_process();
+          }
+          if (sig & SIG_ADV) {
+            adv_process();
+          }
+          if (sig & SIG_TXPWR) {
+            txpwr_process();
+          }
+          if (sig & SIG_POWER) {
+            lowpower_update();
+          }
+          if (sig & SIG_TXQ) {
+            link_txq_process();
+            command_process();
+          }
+          if ((sig & SIG_BATCH) && stream_active) {
+            sl_status_t sc = send_stream_notification();
+            if (sc) TLOG("notify stream sc=0x%04lx\r\n", sc);
+          }
         } break;
 
     // -------------------------------
@@ -317,50 +564,7 @@ sl_status_t update_pump_enable_characteristic(uint8_t data_send)
                                                sizeof(data_send),
                                                &data_send);
   if (sc == SL_STATUS_OK) {
-    app_log_info("Attribute written(pump_enable): 0x%02x\r\n", (int)data_send);
-  }
-
-  return sc;
-}
-
-/***************************************************************************//**
- * Updates the Send Error characteristic.
- *
- * Checks the current button state and then writes it into the local GATT table.
- ******************************************************************************/
-sl_status_t update_send_error_characteristic(uint8_t data_send)
-{
-  sl_status_t sc;
-
-
-  // Write attribute in the local GATT database.
-  sc = sl_bt_gatt_server_write_attribute_value(gattdb_send_error,
-                                               0,
-                                               sizeof(data_send),
-                                               &data_send);
-  if (sc == SL_STATUS_OK) {
-    app_log_info("Attribute written(send_error): 0x%02x\r\n", (int)data_send);
-  }
-
-  return sc;
-}
-
-/***************************************************************************//**
- * Updates the Flow Rate characteristic.
- *
- * Checks the current button state and then writes it into the local GATT table.
- ******************************************************************************/
-sl_status_t update_flow_rate_characteristic(uint16_t data_send)
-{
-  sl_status_t sc;
-
-  // Write attribute in the local GATT database.
-  sc = sl_bt_gatt_server_write_attribute_value(gattdb_flow_rate,
-                                               0,
-                                               sizeof(data_send),
-                                               &data_send);
-  if (sc == SL_STATUS_OK) {
-    app_log_info("Attribute written(flow_rate): 0x%02x\r\n", (int)data_send);
+    LOG_DEBUG(BLE, "Attribute written(pump_enable): 0x%02x\r\n", (int)data_send);
   }
 
   return sc;
@@ -375,8 +579,6 @@ sl_status_t update_flow_rate_characteristic(uint16_t data_send)
 sl_status_t send_flow_rate_notification(uint16_t data_send)
 {
   sl_status_t sc;
-  app_log("data to send (flow_rate): %d", data_send);
-  size_t data_len = sizeof(data_send);
 
   // Read flow rate characteristic stored in local GATT database.
   /*sc = sl_bt_gatt_server_read_attribute_value(gattdb_flow_rate,
@@ -388,15 +590,14 @@ sl_status_t send_flow_rate_notification(uint16_t data_send)
     app_log("Cannot read gattdb_flow_rate.\r\n");
     return sc;
   }*/
-  app_log("gattdb_flow_rate vaules: len:%d data:%d.\r\n",data_len, data_send);
   // Send characteristic notification.
-  sc = sl_bt_gatt_server_notify_all(gattdb_flow_rate,
-                                    sizeof(data_send),
-                                    &data_send);
+  sc = link_notify(LINK_ALL, gattdb_flow_rate,
+                   sizeof(data_send),
+                   (const uint8_t *)&data_send);
   if (sc == SL_STATUS_OK) {
-    app_log_append(" Notification sent (Flow rate): 0x%02x\r\n", (int)data_send);
-  }else {
-      app_log("Cannot send gattdb_flow_rate.\r\n   sc = %d", sc);
+    TLOG("Notification sent (Flow rate): %u\r\n", data_send);
+  } else {
+    TLOG("Cannot send gattdb_flow_rate sc=0x%04lx\r\n", sc);
   }
   return sc;
 }
@@ -410,9 +611,6 @@ sl_status_t send_flow_rate_notification(uint16_t data_send)
 sl_status_t send_error_state_notification(uint8_t data_send)
 {
   sl_status_t sc;
-  size_t data_len = sizeof(data_send);
-
-  app_log("data to send (send_error): %d", data_send);
 
   // Error error state characteristic stored in local GATT database.
  /* sc = sl_bt_gatt_server_read_attribute_value(gattdb_send_error,
@@ -426,16 +624,162 @@ sl_status_t send_error_state_notification(uint8_t data_send)
   }*/
 
   // Send characteristic notification.
-  sc = sl_bt_gatt_server_notify_all(gattdb_send_error,
-                                    sizeof(data_send),
-                                    &data_send);
+  sc = link_notify(LINK_ALL, gattdb_send_error,
+                   sizeof(data_send),
+                   &data_send);
   if (sc == SL_STATUS_OK) {
-    app_log_append(" Notification sent (Error state): 0x%02x\r\n", (int)data_send);
-    app_log("gattdb_send_error vaules: len:%d data:%d.\r\n",data_len, data_send);
-  }else {
-      app_log("Cannot send gattdb_send_error.\r\n  sc = %d\r\n", sc);
-      app_log("notify(send_error) sc=%lu (0x%04lx)\r\n",
-              (unsigned long)sc, (unsigned long)sc);
+    TLOG("Notification sent (Error state): 0x%02x\r\n", data_send);
+  } else {
+    TLOG("Cannot send gattdb_send_error sc=0x%04lx\r\n", sc);
   }
   return sc;
 }
+
+/***************************************************************************//**
+ * Sends notification of the Telemetry characteristic.
+ *
+ * Packs the latest sample into the fixed Telemetry layout and sends it as a
+ * single notification.
+ ******************************************************************************/
+sl_status_t send_telemetry_notification(void)
+{
+  telemetry_sample_t sample;
+  uint8_t buf[TELEMETRY_PACKED_LEN];
+
+  telemetry_get_latest(&sample);
+  size_t len = telemetry_pack(&sample, buf);
+
+  // Send characteristic notification.
+  return link_notify(LINK_ALL, gattdb_telemetry, len, buf);
+}
+
+/***************************************************************************//**
+ * Sends notification of the Telemetry Stream characteristic.
+ *
+ * Takes the batch completed by the sampler and sends it as one notification
+ * sized to the negotiated ATT_MTU.
+ ******************************************************************************/
+sl_status_t send_stream_notification(void)
+{
+  uint8_t buf[TELEMETRY_BATCH_MAX_LEN];
+
+  size_t len = telemetry_batch_take(buf, sizeof(buf));
+  if (len == 0) {
+    return SL_STATUS_OK;
+  }
+
+  // Send characteristic notification.
+  return link_notify(LINK_ALL, gattdb_telemetry_stream, len, buf);
+}
+
+/***************************************************************************//**
+ * Notifies the Link Parameters characteristic to the connection.
+ *
+ * Sends the parameters achieved on the given connection to that connection
+ * only; reads are served from gatt_read.c (user type characteristic).
+ ******************************************************************************/
+sl_status_t send_link_params_notification(uint8_t connection)
+{
+  link_params_t params;
+  uint8_t buf[LINK_PARAMS_PACKED_LEN];
+
+  if (!link_get_params(connection, &params)) {
+    return SL_STATUS_NOT_FOUND;
+  }
+  size_t len = link_pack_params(&params, buf);
+
+  return link_notify(connection, gattdb_link_params, len, buf);
+}
+
+/***************************************************************************//**
+ * Updates the advertising data with the latest sample in BTHome v2 format.
+ *
+ * Called whenever a published sample changes, so passive scanners (e.g. Home
+ * Assistant) receive flow, fault state and volume without connecting. The
+ * objects are AES-CCM encrypted with the BTHome bind key.
+ ******************************************************************************/
+sl_status_t update_advertising_data(void)
+{
+  telemetry_sample_t sample;
+  uint8_t buf[BTHOME_ADV_MAX_LEN];
+
+  telemetry_get_latest(&sample);
+  size_t len = bthome_build_adv(&sample, buf);
+  if (len == 0) {
+    // Encryption failed: keep the previous advert rather than leak plaintext.
+    return SL_STATUS_NOT_READY;
+  }
+
+  return sl_bt_legacy_advertiser_set_data(advertising_set_handle,
+                                          sl_bt_advertiser_advertising_data_packet,
+                                          len, buf);
+}
+
+/***************************************************************************//**
+ * Sets the scan response to the device name from the local GATT table.
+ ******************************************************************************/
+sl_status_t set_scan_response_data(void)
+{
+  uint8_t name[BTHOME_ADV_MAX_LEN];
+  uint8_t buf[BTHOME_ADV_MAX_LEN];
+  size_t name_len = 0;
+
+  sl_status_t sc = sl_bt_gatt_server_read_attribute_value(gattdb_device_name, 0,
+                                                          sizeof(name), &name_len, name);
+  if (sc != SL_STATUS_OK) {
+    return sc;
+  }
+  // The attribute is fixed length, drop the zero padding.
+  while (name_len > 0 && name[name_len - 1] == 0) {
+    name_len--;
+  }
+  size_t len = bthome_build_scan_rsp(name, name_len, buf);
+
+  return sl_bt_legacy_advertiser_set_data(advertising_set_handle,
+                                          sl_bt_advertiser_scan_response_packet,
+                                          len, buf);
+}
+
+/***************************************************************************//**
+ * Simple Button callback: a press brings advertising back to the fast stage,
+ * without the accept list filter, so a new gateway can pair.
+ ******************************************************************************/
+void sl_button_on_change(const sl_button_t *handle)
+{
+  if (handle == &sl_button_btn0
+      && sl_button_get_state(handle) == SL_SIMPLE_BUTTON_PRESSED) {
+    adv_open_pairing();
+  }
+}
+
+/***************************************************************************//**
+ * Sends the current values after a bonded client's subscriptions were restored.
+ *
+ * The client did not write its CCCDs on this connection, so it gets the same
+ * first values a fresh subscriber would, without waiting for the next sample.
+ ******************************************************************************/
+void send_restored_notifications(uint8_t connection)
+{
+  sl_status_t sc;
+
+  if (link_is_subscribed(connection, gattdb_flow_rate)) {
+    uint16_t v = shared_get_flow_x100();
+    sc = link_notify(connection, gattdb_flow_rate, sizeof(v), (const uint8_t *)&v);
+    app_log_status_error(sc);
+  }
+  if (link_is_subscribed(connection, gattdb_send_error)) {
+    uint8_t v = shared_get_err();
+    sc = link_notify(connection, gattdb_send_error, sizeof(v), &v);
+    app_log_status_error(sc);
+  }
+  if (link_is_subscribed(connection, gattdb_telemetry)) {
+    telemetry_sample_t sample;
+    uint8_t buf[TELEMETRY_PACKED_LEN];
+    telemetry_get_latest(&sample);
+    size_t len = telemetry_pack(&sample, buf);
+    sc = link_notify(connection, gattdb_telemetry, len, buf);
+    app_log_status_error(sc);
+  }
+  stream_update();
+  lowpower_update();
+}
@@ -53,10 +53,18 @@ sl_status_t update_pump_enable_characteristic(uint8_t data_send);
 sl_status_t send_flow_rate_notification(uint16_t data_send);
 // Sends notification of the Error characteristic.
 sl_status_t send_error_state_notification(uint8_t data_send);
-// Update the Send Error characteristic.
-sl_status_t update_send_error_characteristic(uint8_t data_send);
-// Update the Flow Rate characteristic.
-sl_status_t update_flow_rate_characteristic(uint16_t data_send);
+// Sends notification of the packed Telemetry characteristic (latest sample).
+sl_status_t send_telemetry_notification(void);
+// Sends the ready streaming batch as one Telemetry Stream notification.
+sl_status_t send_stream_notification(void);
+// Notifies the Link Parameters characteristic to that connection.
+sl_status_t send_link_params_notification(uint8_t connection);
+// Updates the advertising data (BTHome v2) with the latest sample.
+sl_status_t update_advertising_data(void);
+// Sets the scan response data (device name).
+sl_status_t set_scan_response_data(void);
+// Sends the current values to a bonded client whose subscriptions were restored.
+void send_restored_notifications(uint8_t connection);
 
 uint16_t shared_get_flow_x100(void);
 void shared_set_flow_x100(uint16_t v);
@@ -66,6 +74,12 @@ void shared_set_err(uint8_t v);
 
 #define SIG_FLOW  (1u << 0)
 #define SIG_ERR   (1u << 1)
+#define SIG_BATCH (1u << 2)   // a streaming batch is ready to be sent
+#define SIG_LINK  (1u << 3)   // connection parameter demand changed
+#define SIG_TXQ   (1u << 4)   // retry queued notifications
+#define SIG_ADV   (1u << 5)   // advertising stage elapsed or kick
+#define SIG_TXPWR (1u << 6)   // TX power control poll
+#define SIG_POWER (1u << 7)   // low-power profile conditions changed
 
 extern volatile uint16_t g_flow_x100;
 extern volatile uint8_t  g_err;
@@ -23,6 +23,14 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_flow_rate                      27
 #define gattdb_pump_enable                    30
 #define gattdb_send_error                     32
+#define gattdb_telemetry                      35
+#define gattdb_telemetry_stream               38
+#define gattdb_link_params                    41
+#define gattdb_tx_queue_stats                 44
+#define gattdb_command                        46
+#define gattdb_adv_state                      49
+#define gattdb_diagnostics                    51
+#define gattdb_energy_stats                   53
 
 
 #endif // __GATT_DB_H
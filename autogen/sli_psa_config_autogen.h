@@ -6,6 +6,7 @@
 #define PSA_WANT_KEY_TYPE_AES 1
 #define PSA_WANT_ALG_ECB_NO_PADDING 1
 #define PSA_WANT_ALG_CMAC 1
+#define PSA_WANT_ALG_CCM 1
 #define PSA_WANT_KEY_TYPE_ECC_PUBLIC_KEY 1
 #define PSA_WANT_KEY_TYPE_ECC_KEY_PAIR_BASIC 1
 #define PSA_WANT_KEY_TYPE_ECC_KEY_PAIR_IMPORT 1
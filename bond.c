@@ -0,0 +1,221 @@
+// -----------------------------------------------------------------------------
+// bond.c — LE Secure Connections bonding and persisted subscriptions
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Configure the security manager for LE Secure Connections only, Just Works
+//     (no display or keys on the module), with bonding. The stack keeps the
+//     bonding keys in NVM3 itself.
+//   • Keep the notification subscriptions of every bonded client in NVM3 (one
+//     object per bonding handle, link.c subscription bits). When a bonded
+//     client reconnects and the link is encrypted, they are restored, so data
+//     flows without the client rediscovering and rewriting the CCCDs.
+//   • Ask a known bonded central to encrypt right after connecting, which is
+//     what gates the restore.
+//   • Keep the accept list equal to the bonding database and remember the
+//     last bonded central, for filtered and directed advertising (adv.c).
+//
+// Concurrency model & safety notes:
+//   • Everything runs in BLE task context (sl_bt_on_event).
+//   • The saved bits are only written when they change on a bonded link, so
+//     the NVM3 wear follows CCCD writes, not samples.
+//
+// -----------------------------------------------------------------------------
+
+#include "bond.h"
+#include "link.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "sl_bluetooth.h"
+#include "sl_bluetooth_connection_config.h"
+#include "nvm3_default.h"
+
+// NVM3 objects (application key range): subscription bits per bonding handle
+#define NVM3_KEY_BOND_SUBS_BASE  0x01100u
+#define NVM3_KEY_BOND_LAST       0x01180u   // bonding handle of the last central
+
+// Stack bonding database: when full, a new bonding replaces the oldest one.
+#define BOND_POLICY_REPLACE_OLDEST  1u
+
+#define BOND_NO_CONNECTION  0xFFu
+
+// ---- Internal State --------------------------------------------------------------
+// Bonded connections still waiting for encryption before their restore
+static uint8_t s_restore_pending[SL_BT_CONFIG_MAX_CONNECTIONS];
+static uint8_t s_accept_count = 0;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static nvm3_ObjectKey_t subs_key(uint8_t bonding)
+{
+  return NVM3_KEY_BOND_SUBS_BASE + bonding;
+}
+
+static void pending_set(uint8_t connection, bool on)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (on && s_restore_pending[i] == BOND_NO_CONNECTION) {
+      s_restore_pending[i] = connection;
+      return;
+    }
+    if (!on && s_restore_pending[i] == connection) {
+      s_restore_pending[i] = BOND_NO_CONNECTION;
+      return;
+    }
+  }
+}
+
+static bool pending_has(uint8_t connection)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_restore_pending[i] == connection) return true;
+  }
+  return false;
+}
+
+static void subs_save(uint8_t connection, uint8_t bonding)
+{
+  uint32_t subs = link_get_subscriptions(connection);
+  uint32_t saved = 0;
+  Ecode_t ec = nvm3_readData(nvm3_defaultHandle, subs_key(bonding), &saved, sizeof(saved));
+  if (ec == ECODE_NVM3_OK && saved == subs) return;
+
+  ec = nvm3_writeData(nvm3_defaultHandle, subs_key(bonding), &subs, sizeof(subs));
+  if (ec != ECODE_NVM3_OK) {
+    LOG_ERROR(STORAGE, "Bond %u: saving subscriptions failed ec=0x%04lx\r\n",
+                       (unsigned)bonding, (unsigned long)ec);
+  }
+}
+
+static void last_save(uint8_t bonding)
+{
+  uint8_t last = LINK_NO_BONDING;
+  Ecode_t ec = nvm3_readData(nvm3_defaultHandle, NVM3_KEY_BOND_LAST, &last, sizeof(last));
+  if (ec == ECODE_NVM3_OK && last == bonding) return;
+  (void)nvm3_writeData(nvm3_defaultHandle, NVM3_KEY_BOND_LAST, &bonding, sizeof(bonding));
+}
+
+// Rebuild the accept list from the bonding database.
+static void accept_list_refresh(void)
+{
+  bd_addr addr;
+  uint8_t type, mode, key_size;
+
+  s_accept_count = 0;
+  sl_status_t sc = sl_bt_accept_list_remove_all_devices();
+  for (uint8_t i = 0; sc == SL_STATUS_OK && i < BOND_MAX_BONDINGS; i++) {
+    if (sl_bt_sm_get_bonding_details(i, &addr, &type, &mode, &key_size) != SL_STATUS_OK) {
+      continue;   // free slot
+    }
+    sc = sl_bt_accept_list_add_device_by_bonding(i);
+    if (sc == SL_STATUS_OK) s_accept_count++;
+  }
+  if (sc != SL_STATUS_OK) {
+    LOG_ERROR(BLE, "Accept list update failed sc=0x%04lx\r\n", (unsigned long)sc);
+  }
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void bond_init(void)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    s_restore_pending[i] = BOND_NO_CONNECTION;
+  }
+
+  sl_status_t sc = sl_bt_sm_configure(SL_BT_SM_CONFIGURATION_SC_ONLY
+                                      | SL_BT_SM_CONFIGURATION_BONDING_REQUIRED,
+                                      sl_bt_sm_io_capability_noinputnooutput);
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_sm_store_bonding_configuration(BOND_MAX_BONDINGS, BOND_POLICY_REPLACE_OLDEST);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_sm_set_bondable_mode(1);
+  }
+  if (sc != SL_STATUS_OK) {
+    LOG_ERROR(BLE, "Security manager setup failed sc=0x%04lx\r\n", (unsigned long)sc);
+  }
+  accept_list_refresh();
+}
+
+void bond_opened(uint8_t connection, uint8_t bonding)
+{
+  if (bonding >= BOND_MAX_BONDINGS) return;   // unknown central
+
+  link_set_bonding(connection, bonding);
+  last_save(bonding);
+  pending_set(connection, true);
+  // The central normally starts encryption itself; asking saves a round trip.
+  sl_status_t sc = sl_bt_sm_increase_security(connection);
+  if (sc != SL_STATUS_OK) {
+    LOG_WARN(BLE, "Bond %u: encryption request failed sc=0x%04lx\r\n",
+                  (unsigned)bonding, (unsigned long)sc);
+  }
+}
+
+void bond_bonded(uint8_t connection, uint8_t bonding)
+{
+  if (bonding >= BOND_MAX_BONDINGS) return;
+  // Re-encryption of a known bond: the restore runs from bond_encrypted().
+  if (link_get_bonding(connection) == bonding) return;
+
+  link_set_bonding(connection, bonding);
+  pending_set(connection, false);
+  subs_save(connection, bonding);
+  last_save(bonding);
+  accept_list_refresh();
+  LOG_INFO(BLE, "Bond %u: new bonding (conn %u)\r\n", (unsigned)bonding, (unsigned)connection);
+}
+
+bool bond_encrypted(uint8_t connection)
+{
+  if (!pending_has(connection)) return false;
+  pending_set(connection, false);
+
+  uint8_t bonding = link_get_bonding(connection);
+  uint32_t saved = 0;
+  Ecode_t ec = nvm3_readData(nvm3_defaultHandle, subs_key(bonding), &saved, sizeof(saved));
+  if (ec != ECODE_NVM3_OK || saved == 0) return false;
+
+  // CCCDs the client already rewrote on this connection are kept as well.
+  link_restore_subscriptions(connection, saved | link_get_subscriptions(connection));
+  subs_save(connection, bonding);
+  LOG_INFO(BLE, "Bond %u: subscriptions restored (0x%02lx)\r\n",
+                (unsigned)bonding, (unsigned long)saved);
+  return true;
+}
+
+void bond_subscriptions_changed(uint8_t connection)
+{
+  uint8_t bonding = link_get_bonding(connection);
+  // Before the restore only a part of the saved set may be enabled.
+  if (bonding == LINK_NO_BONDING || pending_has(connection)) return;
+  subs_save(connection, bonding);
+}
+
+void bond_failed(uint8_t connection, uint16_t reason)
+{
+  pending_set(connection, false);
+  LOG_WARN(BLE, "Bonding failed (conn %u) reason=0x%04x\r\n", (unsigned)connection, (unsigned)reason);
+}
+
+void bond_closed(uint8_t connection)
+{
+  pending_set(connection, false);
+}
+
+uint8_t bond_accept_list_count(void)
+{
+  return s_accept_count;
+}
+
+bool bond_get_last_central(bd_addr *address, uint8_t *address_type)
+{
+  uint8_t last = LINK_NO_BONDING, mode, key_size;
+  Ecode_t ec = nvm3_readData(nvm3_defaultHandle, NVM3_KEY_BOND_LAST, &last, sizeof(last));
+  if (ec != ECODE_NVM3_OK || last >= BOND_MAX_BONDINGS) return false;
+
+  // The bonding may have been replaced since.
+  return sl_bt_sm_get_bonding_details(last, address, address_type, &mode, &key_size)
+         == SL_STATUS_OK;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_bluetooth.h"
+
+// LE Secure Connections kötés (Just Works, a modulnak nincs kijelzője /
+// billentyűzete). A kulcsokat a stack NVM3-ban tárolja; a feliratkozásokat
+// (link.c bitek) ez a modul menti bonding handle szerint, így egy kötött
+// gateway újrakapcsolódás után azonnal kapja az értesítéseket.
+
+#define BOND_MAX_BONDINGS  4u
+
+// Boot után: SM konfiguráció, bondable mód, kötés tároló
+void bond_init(void);
+
+// Kapcsolat megnyílt (bonding: a stack bonding handle-je, 0xFF ha ismeretlen).
+// Kötött eszköznél titkosítást kér.
+void bond_opened(uint8_t connection, uint8_t bonding);
+// Új kötés jött létre (sm_bonded)
+void bond_bonded(uint8_t connection, uint8_t bonding);
+// A kapcsolat titkosítva van (security_mode > 1. szint). true, ha a mentett
+// feliratkozások most álltak vissza; ilyenkor az app elküldi az aktuális értékeket.
+bool bond_encrypted(uint8_t connection);
+// Feliratkozás változott: kötött kapcsolatnál mentés NVM3-ba
+void bond_subscriptions_changed(uint8_t connection);
+// Sikertelen kötés (pl. a central elvesztette a kulcsot)
+void bond_failed(uint8_t connection, uint16_t reason);
+// Kapcsolat bontva (függő visszaállítás törlése)
+void bond_closed(uint8_t connection);
+
+// Accept list = kötött eszközök (boot és új kötés után frissül); elemszám
+uint8_t bond_accept_list_count(void);
+// Az utoljára kapcsolódott kötött central címe; false, ha nincs (már)
+bool bond_get_last_central(bd_addr *address, uint8_t *address_type);
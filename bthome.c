@@ -0,0 +1,284 @@
+// -----------------------------------------------------------------------------
+// bthome.c — BTHome v2 advertising payload
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Encode flow rate, fault state and the total pumped volume into a BTHome v2
+//     service data element, so passive scanners read the pump without a GATT
+//     connection; GATT is then only needed for control.
+//   • Encrypt the objects with AES-CCM as BTHome v2 specifies (nonce = MAC +
+//     UUID + device info + counter, 4 byte MIC), using a 16 byte bind key kept
+//     in NVM3. PSA runs the cipher on the Secure Engine / CRYPTOACC.
+//   • Measure the cost of every encryption with the DWT cycle counter, so the
+//     refresh rate can be chosen from data.
+//   • Build the scan response carrying the device name, which no longer fits
+//     next to the service data in the 31 byte advertising PDU.
+//
+// Concurrency model & safety notes:
+//   • Called from BLE task context only (app.c).
+//   • CCM must never reuse a nonce under one key. The counter is persisted in
+//     blocks: at boot the next BTHOME_COUNTER_BLOCK values are reserved in NVM3,
+//     so after a reset the counter continues above anything already sent.
+//
+// Hardware assumptions:
+//   • The identity address (public or static) is the advertising address the
+//     receivers use in the nonce.
+//
+// -----------------------------------------------------------------------------
+
+#include "bthome.h"
+#include "control.h"
+#include "sl_bluetooth.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "em_device.h"
+#include "nvm3_default.h"
+#include "psa/crypto.h"
+
+// ---- BTHome v2 constants --------------------------------------------------------
+#define AD_TYPE_FLAGS          0x01u
+#define AD_TYPE_COMPLETE_NAME  0x09u
+#define AD_TYPE_SHORT_NAME     0x08u
+#define AD_TYPE_SERVICE_DATA   0x16u
+#define AD_FLAGS_LE_GENERAL    0x06u   // LE general discoverable, BR/EDR not supported
+
+#define BTHOME_UUID            0xFCD2u
+#define BTHOME_INFO_V2         0x40u   // version 2, regular interval
+#define BTHOME_INFO_ENCRYPTED  0x01u
+
+#define BTHOME_OBJ_PACKET_ID   0x00u
+#define BTHOME_OBJ_PROBLEM     0x26u
+#define BTHOME_OBJ_FLOW_RATE   0x49u   // volume flow rate, u16, 0.001 m3/h
+#define BTHOME_OBJ_VOLUME      0x4Eu   // volume, u32, 0.001 L
+#define BTHOME_OBJ_MAX_LEN     12u     // all objects above
+
+// ---- Encryption parameters -------------------------------------------------------
+#define BINDKEY_LEN            16u
+#define CCM_NONCE_LEN          13u
+#define CCM_MIC_LEN            4u
+#define CCM_ALG                PSA_ALG_AEAD_WITH_SHORTENED_TAG(PSA_ALG_CCM, CCM_MIC_LEN)
+
+// NVM3 objects (application key range)
+#define NVM3_KEY_BTHOME_BINDKEY  0x01000u
+#define NVM3_KEY_BTHOME_COUNTER  0x01001u
+#define BTHOME_COUNTER_BLOCK     4096u   // counter values reserved per NVM3 write
+
+// Log the encryption cost every this many adverts
+#define CRYPTO_LOG_EVERY         256u
+
+// ---- Internal State --------------------------------------------------------------
+static uint8_t  s_packet_id = 0;
+static psa_key_id_t s_key = 0;         // 0: not encrypting
+static uint8_t  s_mac[6];              // identity address, most significant byte first
+static uint32_t s_counter = 0;         // next CCM counter
+static uint32_t s_counter_limit = 0;   // first value not yet reserved in NVM3
+static bthome_crypto_stats_t s_crypto;
+static uint64_t s_crypto_sum_us = 0;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+// Total volume since boot [mL]: pulses / (Hz per L/min * 60 s).
+static uint32_t volume_ml(uint32_t pulses)
+{
+  uint32_t cal_x100 = hydro_get_flow_cal_x100();
+  return (uint32_t)(((uint64_t)pulses * 1000u * 100u) / (cal_x100 * 60u));
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+  return p + 4;
+}
+
+static bool counter_reserve(void)
+{
+  s_counter_limit = s_counter + BTHOME_COUNTER_BLOCK;
+  Ecode_t ec = nvm3_writeData(nvm3_defaultHandle, NVM3_KEY_BTHOME_COUNTER,
+                              &s_counter_limit, sizeof(s_counter_limit));
+  return ec == ECODE_NVM3_OK;
+}
+
+// Bind key from NVM3; generated (and printed once for pairing) on first boot.
+static bool bindkey_load(uint8_t *key)
+{
+  Ecode_t ec = nvm3_readData(nvm3_defaultHandle, NVM3_KEY_BTHOME_BINDKEY, key, BINDKEY_LEN);
+  if (ec == ECODE_NVM3_OK) return true;
+  if (ec != ECODE_NVM3_ERR_KEY_NOT_FOUND) return false;
+
+  if (psa_generate_random(key, BINDKEY_LEN) != PSA_SUCCESS) return false;
+  ec = nvm3_writeData(nvm3_defaultHandle, NVM3_KEY_BTHOME_BINDKEY, key, BINDKEY_LEN);
+  if (ec != ECODE_NVM3_OK) return false;
+
+  // Shown at the default level: it is needed to add the device to Home Assistant.
+  if (LOG_ON(STORAGE, APP_LOG_LEVEL_WARNING)) {
+    app_log_warning("BTHome bind key (new): ");
+    for (uint32_t i = 0; i < BINDKEY_LEN; i++) app_log_append("%02x", key[i]);
+    app_log_append("\r\n");
+  }
+  return true;
+}
+
+static uint32_t cycles_to_us(uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)cycles * 1000000u) / SystemCoreClockGet());
+}
+
+// Encrypt the objects in place after the device info byte and append the
+// counter and the MIC. Returns the new object area length, 0 on failure.
+static size_t encrypt_objects(uint8_t info, uint8_t *obj, size_t len)
+{
+  if (s_counter == s_counter_limit && !counter_reserve()) return 0;
+
+  uint8_t nonce[CCM_NONCE_LEN];
+  for (uint32_t i = 0; i < 6; i++) nonce[i] = s_mac[i];
+  nonce[6] = (uint8_t)BTHOME_UUID;
+  nonce[7] = (uint8_t)(BTHOME_UUID >> 8);
+  nonce[8] = info;
+  (void)put_u32(&nonce[9], s_counter);
+
+  uint8_t out[BTHOME_OBJ_MAX_LEN + CCM_MIC_LEN];
+  size_t out_len = 0;
+
+  uint32_t t0 = DWT->CYCCNT;
+  psa_status_t st = psa_aead_encrypt(s_key, CCM_ALG, nonce, sizeof(nonce), NULL, 0,
+                                     obj, len, out, sizeof(out), &out_len);
+  uint32_t us = cycles_to_us(DWT->CYCCNT - t0);
+  if (st != PSA_SUCCESS || out_len != len + CCM_MIC_LEN) {
+    LOG_ERROR(BLE, "BTHome encrypt failed: %ld\r\n", (long)st);
+    return 0;
+  }
+
+  s_crypto.count++;
+  s_crypto.last_us = us;
+  if (us > s_crypto.max_us) s_crypto.max_us = us;
+  s_crypto_sum_us += us;
+  s_crypto.avg_us = (uint32_t)(s_crypto_sum_us / s_crypto.count);
+  if ((s_crypto.count % CRYPTO_LOG_EVERY) == 0) {
+    LOG_INFO(BLE, "BTHome encrypt: avg %lu us, max %lu us (%lu adverts)\r\n",
+                  (unsigned long)s_crypto.avg_us, (unsigned long)s_crypto.max_us,
+                  (unsigned long)s_crypto.count);
+  }
+
+  // ciphertext | counter | MIC
+  for (size_t i = 0; i < len; i++) obj[i] = out[i];
+  uint8_t *p = put_u32(obj + len, s_counter++);
+  for (size_t i = 0; i < CCM_MIC_LEN; i++) p[i] = out[len + i];
+  return len + 4u + CCM_MIC_LEN;
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+bool bthome_init(void)
+{
+#if BTHOME_ENCRYPT
+  bd_addr addr;
+  uint8_t type;
+  uint8_t key[BINDKEY_LEN];
+
+  if (sl_bt_system_get_identity_address(&addr, &type) != SL_STATUS_OK) return false;
+  for (uint32_t i = 0; i < 6; i++) s_mac[i] = addr.addr[5 - i];
+
+  if (!bindkey_load(key)) {
+    LOG_ERROR(STORAGE, "BTHome bind key unavailable, adverts disabled\r\n");
+    return false;
+  }
+
+  psa_key_attributes_t attr = PSA_KEY_ATTRIBUTES_INIT;
+  psa_set_key_type(&attr, PSA_KEY_TYPE_AES);
+  psa_set_key_bits(&attr, BINDKEY_LEN * 8u);
+  psa_set_key_usage_flags(&attr, PSA_KEY_USAGE_ENCRYPT);
+  psa_set_key_algorithm(&attr, CCM_ALG);
+  psa_set_key_lifetime(&attr, PSA_KEY_LIFETIME_VOLATILE);
+  psa_status_t st = psa_import_key(&attr, key, sizeof(key), &s_key);
+  for (uint32_t i = 0; i < BINDKEY_LEN; i++) key[i] = 0;
+  if (st != PSA_SUCCESS) {
+    LOG_ERROR(STORAGE, "BTHome key import failed: %ld\r\n", (long)st);
+    s_key = 0;
+    return false;
+  }
+
+  // Continue above every counter value reserved before the last reset.
+  Ecode_t ec = nvm3_readData(nvm3_defaultHandle, NVM3_KEY_BTHOME_COUNTER,
+                             &s_counter, sizeof(s_counter));
+  if (ec != ECODE_NVM3_OK) s_counter = 0;
+  if (!counter_reserve()) {
+    s_key = 0;
+    return false;
+  }
+
+  // Cycle counter for the per-advert cost
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  return true;
+#else
+  return true;
+#endif
+}
+
+void bthome_get_crypto_stats(bthome_crypto_stats_t *out)
+{
+  *out = s_crypto;
+}
+
+size_t bthome_build_adv(const telemetry_sample_t *s, uint8_t *buf)
+{
+  uint8_t *p = buf;
+
+  *p++ = 2;
+  *p++ = AD_TYPE_FLAGS;
+  *p++ = AD_FLAGS_LE_GENERAL;
+
+  uint8_t *len = p++;   // service data length, filled in at the end
+  *p++ = AD_TYPE_SERVICE_DATA;
+  *p++ = (uint8_t)BTHOME_UUID;
+  *p++ = (uint8_t)(BTHOME_UUID >> 8);
+  uint8_t info = BTHOME_INFO_V2;
+#if BTHOME_ENCRYPT
+  info |= BTHOME_INFO_ENCRYPTED;
+#endif
+  *p++ = info;
+
+  uint8_t *obj = p;
+  *p++ = BTHOME_OBJ_PACKET_ID;
+  *p++ = s_packet_id++;
+
+  *p++ = BTHOME_OBJ_PROBLEM;
+  *p++ = (s->faults != HYDRO_ERR_NONE) ? 1u : 0u;
+
+  // 0.01 L/min -> 0.001 m3/h: * 60 / 100
+  uint32_t flow = ((uint32_t)s->flow_x100 * 60u + 50u) / 100u;
+  *p++ = BTHOME_OBJ_FLOW_RATE;
+  *p++ = (uint8_t)flow;
+  *p++ = (uint8_t)(flow >> 8);
+
+  *p++ = BTHOME_OBJ_VOLUME;
+  p = put_u32(p, volume_ml(s->pulses));
+
+#if BTHOME_ENCRYPT
+  if (s_key == 0) return 0;
+  size_t n = encrypt_objects(info, obj, (size_t)(p - obj));
+  if (n == 0) return 0;
+  p = obj + n;
+#else
+  (void)obj;
+#endif
+
+  *len = (uint8_t)(p - len - 1);
+  return (size_t)(p - buf);
+}
+
+size_t bthome_build_scan_rsp(const uint8_t *name, size_t name_len, uint8_t *buf)
+{
+  uint8_t type = AD_TYPE_COMPLETE_NAME;
+  if (name_len > BTHOME_ADV_MAX_LEN - 2u) {
+    name_len = BTHOME_ADV_MAX_LEN - 2u;
+    type = AD_TYPE_SHORT_NAME;
+  }
+  buf[0] = (uint8_t)(name_len + 1u);
+  buf[1] = type;
+  for (size_t i = 0; i < name_len; i++) buf[2 + i] = name[i];
+  return name_len + 2u;
+}
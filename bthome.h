@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "telemetry.h"
+
+// BTHome v2 hirdetés (kapcsolat nélküli telemetria passzív scannereknek,
+// pl. Home Assistant). Objektumok (ID szerint növekvő sorrendben):
+//   0x00 packet id (u8), 0x26 problem (u8, hiba van),
+//   0x49 volume flow rate (u16, 0.001 m3/h), 0x4E volume (u32, 0.001 L)
+#define BTHOME_ADV_MAX_LEN  31u   // legacy advertising PDU adat
+
+// Titkosítás (AES-CCM, 4 bájtos MIC) a BTHome v2 szerint; a 16 bájtos bind
+// key NVM3-ban van, első induláskor generálódik. 0: nyílt hirdetés.
+#define BTHOME_ENCRYPT      1
+
+// Hirdetésenkénti titkosítási költség (mérés a CPU ciklusszámlálóval)
+typedef struct {
+  uint32_t count;     // titkosított hirdetések
+  uint32_t last_us;
+  uint32_t max_us;
+  uint32_t avg_us;
+} bthome_crypto_stats_t;
+
+// Init a boot esemény után: bind key betöltés/generálás, PSA kulcs import,
+// nonce-hoz az identity address. false, ha a titkosítás nem használható.
+bool bthome_init(void);
+void bthome_get_crypto_stats(bthome_crypto_stats_t *out);
+
+// Advertising adat (Flags + BTHome service data) a mintából; a packet id
+// minden hívással nő, így a vevő ki tudja szűrni az ismétléseket.
+// 0, ha a titkosítás sikertelen (ilyenkor nem szabad nyílt adatot küldeni).
+size_t bthome_build_adv(const telemetry_sample_t *s, uint8_t *buf);
+
+// Scan response: teljes eszköznév (rövidítve, ha nem fér el)
+size_t bthome_build_scan_rsp(const uint8_t *name, size_t name_len, uint8_t *buf);
@@ -0,0 +1,360 @@
+// -----------------------------------------------------------------------------
+// command.c — Binary command protocol (Command characteristic)
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Parse opcode + TLV packets written to the Command characteristic, with or
+//     without response (see command.h for the wire format).
+//   • Apply a CMD_OP_SET packet atomically: every TLV is validated first, and
+//     only a fully valid packet touches the pump. Threshold TLVs are merged into
+//     one hydro_limits_t, so sample_cb() sees either the old or the new set.
+//   • Acknowledge faults, and serve history downloads from telemetry.c as a
+//     sequence of notifications paced by the link TX queue.
+//   • Answer every packet with a status notification to the writing connection.
+//
+// Concurrency model & safety notes:
+//   • Everything runs in BLE task context (sl_bt_on_event).
+//   • Zero-copy: the parser walks the value array of the stack event in place;
+//     nothing points into it after command_handle() returns (curve points and
+//     advertising stages are applied before that).
+//   • A history download stops whenever the connection has queued
+//     notifications and resumes from command_process() after the queue drains,
+//     so it never floods the stack's TX buffers.
+//
+// -----------------------------------------------------------------------------
+
+#include "command.h"
+#include "app.h"
+#include "control.h"
+#include "telemetry.h"
+#include "link.h"
+#include "adv.h"
+#include "txpwr.h"
+#include "loglevel.h"
+#include "gatt_db.h"
+#include "app_log.h"
+#include <stdbool.h>
+
+#define CMD_REPLY_LEN         3u
+#define CMD_HIST_FRAME_LEN    (CMD_REPLY_LEN + TELEMETRY_PACKED_LEN)
+#define CMD_HIST_DONE_LEN     (CMD_REPLY_LEN + 5u)
+#define CMD_NO_CONNECTION     0xFFu
+
+// ---- Internal State --------------------------------------------------------------
+// Staged CMD_OP_SET: what the packet sets, validated but not yet applied.
+typedef struct {
+  uint32_t        present;     // 1u << CMD_TLV_*
+  uint8_t         enable;
+  uint16_t        duty;
+  uint8_t         thermal;
+  const uint8_t  *curve;       // points, still in the event buffer
+  uint8_t         curve_n;
+  hydro_limits_t  limits;
+  uint16_t        flow_cal;
+  uint16_t        brake_ms;
+  const uint8_t  *adv;         // advertising stages, still in the event buffer
+  uint8_t         adv_n;
+  uint8_t         adv_gateway;
+  uint8_t         tx_warn_db;
+  uint8_t         log_module;
+  uint8_t         log_level;
+} cmd_set_t;
+
+// History download in progress
+static uint8_t  s_hist_conn = CMD_NO_CONNECTION;
+static uint16_t s_hist_cursor;
+static uint8_t  s_hist_left;
+static uint8_t  s_hist_sent;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static uint16_t get_u16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void reply(uint8_t connection, uint8_t op, uint8_t status, uint8_t arg)
+{
+  const uint8_t buf[CMD_REPLY_LEN] = { op, status, arg };
+  (void)link_notify(connection, gattdb_command, sizeof(buf), buf);
+}
+
+// Next TLV at *pos; CMD_STATUS_MALFORMED if it does not fit in the packet.
+static uint8_t tlv_next(const uint8_t *data, size_t len, size_t *pos,
+                        uint8_t *type, const uint8_t **val, uint8_t *vlen)
+{
+  if (*pos + 2u > len) return CMD_STATUS_MALFORMED;
+  *type = data[*pos];
+  *vlen = data[*pos + 1u];
+  if (*pos + 2u + *vlen > len) return CMD_STATUS_MALFORMED;
+  *val = &data[*pos + 2u];
+  *pos += 2u + *vlen;
+  return CMD_STATUS_OK;
+}
+
+// Same rules as hydro_set_thermal_curve(), checked before anything is applied.
+static bool curve_valid(const uint8_t *v, uint8_t n)
+{
+  if (n == 0 || n > HYDRO_CURVE_MAX_POINTS) return false;
+  for (uint8_t i = 0; i < n; i++) {
+    if (get_u16(&v[4u * i + 2u]) > HYDRO_DUTY_PERMILLE_MAX) return false;
+    if (i > 0 && (int16_t)get_u16(&v[4u * i]) <= (int16_t)get_u16(&v[4u * (i - 1u)])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Same rules as adv_set_schedule().
+static bool adv_schedule_valid(const uint8_t *v, uint8_t n)
+{
+  if (n == 0 || n > ADV_MAX_STAGES) return false;
+  for (uint8_t i = 0; i < n; i++) {
+    uint16_t ms = get_u16(&v[4u * i]);
+    if (ms < ADV_INTERVAL_MIN_MS || ms > ADV_INTERVAL_MAX_MS) return false;
+  }
+  return true;
+}
+
+// Validate one SET TLV into the staging area.
+static uint8_t stage_tlv(cmd_set_t *st, uint8_t type, const uint8_t *v, uint8_t vlen)
+{
+  switch (type) {
+    case CMD_TLV_ENABLE:
+    case CMD_TLV_THERMAL_MODE:
+    case CMD_TLV_ADV_GATEWAY:
+      if (vlen != 1u) return CMD_STATUS_MALFORMED;
+      if (v[0] > 1u)  return CMD_STATUS_BAD_VALUE;
+      if (type == CMD_TLV_ENABLE)            st->enable = v[0];
+      else if (type == CMD_TLV_THERMAL_MODE) st->thermal = v[0];
+      else                                   st->adv_gateway = v[0];
+      break;
+    case CMD_TLV_DUTY:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      st->duty = get_u16(v);
+      if (st->duty > HYDRO_DUTY_PERMILLE_MAX) return CMD_STATUS_BAD_VALUE;
+      break;
+    case CMD_TLV_CURVE:
+      if (vlen == 0 || (vlen % 4u) != 0) return CMD_STATUS_MALFORMED;
+      if (!curve_valid(v, vlen / 4u))    return CMD_STATUS_BAD_VALUE;
+      st->curve   = v;
+      st->curve_n = vlen / 4u;
+      break;
+    case CMD_TLV_DRY_LPM:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      st->limits.dry_lpm_x100 = get_u16(v);
+      break;
+    case CMD_TLV_DRY_AFTER_S:
+      if (vlen != 1u) return CMD_STATUS_MALFORMED;
+      if (v[0] == 0)  return CMD_STATUS_BAD_VALUE;
+      st->limits.dry_after_s = v[0];
+      break;
+    case CMD_TLV_STALL_MA:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      st->limits.stall_ma = get_u16(v);
+      break;
+    case CMD_TLV_OPEN_LOAD_MA:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      st->limits.open_load_ma = get_u16(v);
+      break;
+    case CMD_TLV_FLOW_CAL:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      st->flow_cal = get_u16(v);
+      if (st->flow_cal < HYDRO_FLOW_CAL_X100_MIN || st->flow_cal > HYDRO_FLOW_CAL_X100_MAX) {
+        return CMD_STATUS_BAD_VALUE;
+      }
+      break;
+    case CMD_TLV_BRAKE_MS:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      st->brake_ms = get_u16(v);
+      break;
+    case CMD_TLV_ADV_SCHEDULE:
+      if (vlen == 0 || (vlen % 4u) != 0)     return CMD_STATUS_MALFORMED;
+      if (!adv_schedule_valid(v, vlen / 4u)) return CMD_STATUS_BAD_VALUE;
+      st->adv   = v;
+      st->adv_n = vlen / 4u;
+      break;
+    case CMD_TLV_TX_WARN_DB:
+      if (vlen != 1u) return CMD_STATUS_MALFORMED;
+      if (v[0] > TXPWR_WARN_DB_MAX) return CMD_STATUS_BAD_VALUE;
+      st->tx_warn_db = v[0];
+      break;
+    case CMD_TLV_LOG_LEVEL:
+      if (vlen != 2u) return CMD_STATUS_MALFORMED;
+      if (v[0] >= LOG_MOD_COUNT || v[1] > LOG_LEVEL_OFF) return CMD_STATUS_BAD_VALUE;
+      st->log_module = v[0];
+      st->log_level  = v[1];
+      break;
+    default:
+      return CMD_STATUS_BAD_TYPE;
+  }
+  st->present |= 1u << type;
+  return CMD_STATUS_OK;
+}
+
+#define HAS(st, t)  (((st)->present & (1u << (t))) != 0)
+
+// Apply a fully validated SET. The pump is (re)started last, with every new
+// setting already in place.
+static void apply_set(const cmd_set_t *st)
+{
+  if (HAS(st, CMD_TLV_DRY_LPM) || HAS(st, CMD_TLV_DRY_AFTER_S)
+      || HAS(st, CMD_TLV_STALL_MA) || HAS(st, CMD_TLV_OPEN_LOAD_MA)) {
+    hydro_set_limits(&st->limits);
+  }
+  if (HAS(st, CMD_TLV_FLOW_CAL)) (void)hydro_set_flow_cal_x100(st->flow_cal);
+  if (HAS(st, CMD_TLV_BRAKE_MS)) hydro_set_brake_ms(st->brake_ms);
+  if (HAS(st, CMD_TLV_CURVE)) {
+    hydro_curve_point_t pts[HYDRO_CURVE_MAX_POINTS];
+    for (uint8_t i = 0; i < st->curve_n; i++) {
+      pts[i].temp_c_x100   = (int16_t)get_u16(&st->curve[4u * i]);
+      pts[i].duty_permille = get_u16(&st->curve[4u * i + 2u]);
+    }
+    (void)hydro_set_thermal_curve(pts, st->curve_n);
+  }
+  if (HAS(st, CMD_TLV_ADV_SCHEDULE)) {
+    adv_stage_t stages[ADV_MAX_STAGES];
+    for (uint8_t i = 0; i < st->adv_n; i++) {
+      stages[i].interval_ms = get_u16(&st->adv[4u * i]);
+      stages[i].duration_s  = get_u16(&st->adv[4u * i + 2u]);
+    }
+    (void)adv_set_schedule(stages, st->adv_n);
+  }
+  if (HAS(st, CMD_TLV_ADV_GATEWAY)) adv_set_gateway_mode(st->adv_gateway != 0);
+  if (HAS(st, CMD_TLV_TX_WARN_DB)) (void)txpwr_set_warn_db(st->tx_warn_db);
+  if (HAS(st, CMD_TLV_LOG_LEVEL))  (void)loglevel_set(st->log_module, st->log_level);
+  if (HAS(st, CMD_TLV_THERMAL_MODE)) hydro_set_thermal_mode(st->thermal != 0);
+  if (HAS(st, CMD_TLV_DUTY))         hydro_set_duty_permille(st->duty);
+  if (HAS(st, CMD_TLV_ENABLE)) {
+    hydro_enable(st->enable != 0);
+    (void)update_pump_enable_characteristic(st->enable);
+  }
+}
+
+static void handle_set(uint8_t connection, const uint8_t *data, size_t len)
+{
+  cmd_set_t st = { 0 };
+  hydro_get_limits(&st.limits);   // unset thresholds keep their value
+
+  size_t pos = 1;
+  while (pos < len) {
+    size_t at = pos;
+    uint8_t type, vlen;
+    const uint8_t *v;
+    uint8_t status = tlv_next(data, len, &pos, &type, &v, &vlen);
+    if (status == CMD_STATUS_OK) status = stage_tlv(&st, type, v, vlen);
+    if (status != CMD_STATUS_OK) {
+      reply(connection, CMD_OP_SET, status, (uint8_t)at);
+      return;
+    }
+  }
+  if (st.limits.open_load_ma >= st.limits.stall_ma) {
+    reply(connection, CMD_OP_SET, CMD_STATUS_BAD_VALUE, 0);
+    return;
+  }
+
+  apply_set(&st);
+  reply(connection, CMD_OP_SET, CMD_STATUS_OK, 0);
+}
+
+// Final frame: record count, then the measured throughput and the PHY in use.
+static void history_finish(void)
+{
+  link_params_t params = { 0 };
+  uint32_t bps = link_bulk_end(s_hist_conn);
+  (void)link_get_params(s_hist_conn, &params);
+
+  const uint8_t buf[CMD_HIST_DONE_LEN] = {
+    CMD_OP_HISTORY, CMD_STATUS_OK, s_hist_sent,
+    (uint8_t)bps, (uint8_t)(bps >> 8), (uint8_t)(bps >> 16), (uint8_t)(bps >> 24),
+    params.phy,
+  };
+  (void)link_notify(s_hist_conn, gattdb_command, sizeof(buf), buf);
+  (void)send_link_params_notification(s_hist_conn);
+  s_hist_conn = CMD_NO_CONNECTION;
+  link_set_demand(LINK_DEMAND_BULK, false);
+}
+
+static void handle_history(uint8_t connection, const uint8_t *data, size_t len)
+{
+  uint8_t last_n = 0;
+  size_t pos = 1;
+  while (pos < len) {
+    size_t at = pos;
+    uint8_t type, vlen;
+    const uint8_t *v;
+    uint8_t status = tlv_next(data, len, &pos, &type, &v, &vlen);
+    if (status == CMD_STATUS_OK && type != CMD_TLV_HIST_COUNT) status = CMD_STATUS_BAD_TYPE;
+    if (status == CMD_STATUS_OK && vlen != 1u) status = CMD_STATUS_MALFORMED;
+    if (status != CMD_STATUS_OK) {
+      reply(connection, CMD_OP_HISTORY, status, (uint8_t)at);
+      return;
+    }
+    last_n = v[0];
+  }
+
+  if (s_hist_conn != CMD_NO_CONNECTION) {
+    reply(connection, CMD_OP_HISTORY, CMD_STATUS_BUSY, 0);
+    return;
+  }
+
+  s_hist_conn = connection;
+  s_hist_sent = 0;
+  s_hist_left = (last_n == 0) ? TELEMETRY_HISTORY_LEN : last_n;
+  if (!telemetry_history_start(last_n, &s_hist_cursor)) {
+    history_finish();   // nothing stored yet
+    return;
+  }
+  link_set_demand(LINK_DEMAND_BULK, true);
+  link_bulk_begin(connection);
+  command_process();
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void command_handle(uint8_t connection, const uint8_t *data, size_t len)
+{
+  if (len == 0) return;
+
+  switch (data[0]) {
+    case CMD_OP_SET:
+      handle_set(connection, data, len);
+      break;
+    case CMD_OP_FAULT_ACK:
+      hydro_ack_faults();
+      LOG_INFO(CONTROL, "Faults acknowledged (conn %u)\r\n", (unsigned)connection);
+      reply(connection, CMD_OP_FAULT_ACK, CMD_STATUS_OK, 0);
+      break;
+    case CMD_OP_HISTORY:
+      handle_history(connection, data, len);
+      break;
+    default:
+      reply(connection, data[0], CMD_STATUS_BAD_OPCODE, 0);
+      break;
+  }
+}
+
+void command_process(void)
+{
+  while (s_hist_conn != CMD_NO_CONNECTION && !link_txq_busy(s_hist_conn)) {
+    telemetry_sample_t sample;
+    if (s_hist_left == 0 || !telemetry_history_next(&s_hist_cursor, &sample)) {
+      history_finish();
+      return;
+    }
+
+    uint8_t buf[CMD_HIST_FRAME_LEN] = { CMD_OP_HISTORY, CMD_STATUS_MORE, s_hist_sent };
+    (void)telemetry_pack(&sample, &buf[CMD_REPLY_LEN]);
+    (void)link_notify(s_hist_conn, gattdb_command, sizeof(buf), buf);
+    s_hist_sent++;
+    s_hist_left--;
+  }
+}
+
+void command_connection_closed(uint8_t connection)
+{
+  if (s_hist_conn == connection) {
+    s_hist_conn = CMD_NO_CONNECTION;
+    link_set_demand(LINK_DEMAND_BULK, false);
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Bináris parancs protokoll a Command karakterisztikán (write / write without
+// response). Csomag: opcode (u8), majd TLV-k: type (u8), len (u8), value
+// (len bájt, little endian). Válasz értesítésként ugyanazon a karakterisztikán
+// a küldő kapcsolatnak: opcode (u8), status (u8), arg (u8), [adat].
+
+// Opcode-ok
+#define CMD_OP_SET          0x01u  // paraméterek, atomikusan (mind vagy egyik sem)
+#define CMD_OP_FAULT_ACK    0x02u  // hibák nyugtázása (nincs TLV)
+#define CMD_OP_HISTORY      0x03u  // history letöltés (CMD_TLV_HIST_COUNT)
+
+// CMD_OP_SET TLV típusok
+#define CMD_TLV_ENABLE        0x01u  // u8  : pumpa be/ki
+#define CMD_TLV_DUTY          0x02u  // u16 : kézi kitöltés [‰]
+#define CMD_TLV_THERMAL_MODE  0x03u  // u8  : termikus mód be/ki
+#define CMD_TLV_CURVE         0x04u  // n * (i16 hőm. [0.01 °C], u16 kitöltés [‰]), 1..4 pont
+#define CMD_TLV_DRY_LPM       0x05u  // u16 : szárazfutás küszöb [0.01 L/min]
+#define CMD_TLV_DRY_AFTER_S   0x06u  // u8  : szárazfutás késleltetés [s]
+#define CMD_TLV_STALL_MA      0x07u  // u16 : beragadás áram küszöb [mA]
+#define CMD_TLV_OPEN_LOAD_MA  0x08u  // u16 : szakadás áram küszöb [mA]
+#define CMD_TLV_FLOW_CAL      0x09u  // u16 : átfolyásmérő [0.01 Hz / (L/min)]
+#define CMD_TLV_BRAKE_MS      0x0Au  // u16 : fékezési ablak [ms]
+#define CMD_TLV_ADV_SCHEDULE  0x0Bu  // n * (u16 intervallum [ms], u16 időtartam [s]), 1..4 fokozat
+#define CMD_TLV_ADV_GATEWAY   0x0Cu  // u8  : gateway mód (accept list + irányított hirdetés)
+#define CMD_TLV_TX_WARN_DB    0x0Du  // u8  : TX figyelm. küszöb [dB], 0..40 (csak napló, txpwr.h)
+#define CMD_TLV_LOG_LEVEL     0x0Eu  // u8 modul (LOG_MOD_*), u8 szint (0 debug .. 5 ki)
+
+// CMD_OP_HISTORY TLV
+#define CMD_TLV_HIST_COUNT    0x10u  // u8  : utolsó N minta (0 = mind)
+
+// Válasz status; arg hibánál a hibás TLV bájt offsetje a csomagban
+#define CMD_STATUS_OK          0x00u  // kész (history: utolsó keret, arg = rekordszám,
+                                      // adat: átviteli sebesség u32 [bájt/s], phy u8)
+#define CMD_STATUS_MORE        0x01u  // history rekord keret (15 bájt telemetria)
+#define CMD_STATUS_BAD_OPCODE  0x10u
+#define CMD_STATUS_MALFORMED   0x11u  // csonka TLV / rossz hossz
+#define CMD_STATUS_BAD_TYPE    0x12u  // ismeretlen TLV típus
+#define CMD_STATUS_BAD_VALUE   0x13u  // tartományon kívüli érték
+#define CMD_STATUS_BUSY        0x14u  // már fut egy history letöltés
+
+// Egy beérkezett csomag feldolgozása (BLE task). A data a stack esemény
+// pufferére mutat, a parser nem másol.
+void command_handle(uint8_t connection, const uint8_t *data, size_t len);
+
+// Folyamatban lévő history letöltés továbbléptetése (BLE task, SIG_TXQ után)
+void command_process(void);
+
+// A kapcsolat bontásakor a hozzá tartozó letöltés leállítása
+void command_connection_closed(uint8_t connection);
@@ -104,7 +104,7 @@
 
 // <e APP_LOG_LEVEL_FILTER_ENABLE> Threshold filter
 // <i> Enable simple filter for log levels
-#define APP_LOG_LEVEL_FILTER_ENABLE            1
+#define APP_LOG_LEVEL_FILTER_ENABLE            0
 
 // <o APP_LOG_LEVEL_FILTER_THRESHOLD> Threshold
 // <APP_LOG_LEVEL_DEBUG=> DEBUG
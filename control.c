@@ -3,10 +3,15 @@
 // -----------------------------------------------------------------------------
 //
 // Responsibilities of this module:
-//   • Drive the pump H-bridge inputs with a fixed, low-duty PWM (I1A=PWM, I1B=LOW).
+//   • Drive the pump H-bridge inputs with a low-duty PWM (I1A=PWM, I1B=LOW).
+//     Duty is set manually or, in thermal mode, from a temperature -> duty curve.
+//   • Stop the pump with a short active brake (I1A=I1B=HIGH), then coast.
 //   • Count rising edges from a hall-effect flow sensor (e.g., YF-S201).
 //   • Periodically compute flow rate in L/min from pulse counts.
 //   • Detect "dry run" (pump on but measured flow below a threshold for N seconds).
+//   • Tell dry run apart from a seized pump (stall: high current, no flow) and a
+//     disconnected motor (open load: no current) using the pump current (analog.c).
+//   • Sample coolant temperature once per THERMAL_PERIOD_MS (analog.c NTC input).
 //   • Surface live telemetry (flow_x100, err) via shared_* accessors and BLE signal.
 //   • Allow an optional sink callback for debugging/telemetry fan-out.
 //
@@ -14,16 +19,36 @@
 //   • Flow pulses arrive in GPIO IRQ context and increment s_pulses (volatile).
 //   • sample_cb() runs from sleeptimer context and snapshots s_pulses with IRQs
 //     temporarily disabled to avoid torn reads.
+//   • thermal_cb() also runs from sleeptimer context; it is the only writer of
+//     the applied duty while thermal mode is on.
 //   • All other state is accessed in task context (enable/disable).
+//   • The brake window is closed by a one-shot sleeptimer (brake_end_cb), which
+//     is the only place besides pump_on() that touches PUMP_PIN_LOW.
+//   • Low-power profile (hydro_set_low_power(), BLE task): the thermal sampler
+//     is stopped and the last reading is held. The flow input is switched
+//     from edge counting to an EM4WU level wakeup (flow_watch_edges()), so
+//     control.c drops its EM1 requirement. The wake ISR puts edge counting
+//     and EM1 back and raises SIG_POWER; the flow is then watched from task
+//     context (monitor sampling) once the profile has been left.
 //
 // Hardware assumptions:
 //   • PUMP_PIN_LOW is held LOW (I1B=0) while I1A is PWM’d => one-quadrant drive.
-//   • PWM output is routed via TIMER0 CC0 to PUMP_PIN_PWM.
+//   • Driving both inputs HIGH shorts the motor through the low-side switches
+//     (L9110/DRV8833-style "brake"), both LOW releases it (coast).
+//   • PWM output is routed via TIMER0 CC0 to PUMP_PIN_PWM. TIMER0 does not run
+//     in EM2: the PWM holds an EM1 requirement and its clock only while running.
+//   • TIMER0 CC1 is an unrouted compare in the middle of the on-time; its PRS
+//     output triggers the current-sense IADC scan.
 //   • FLOW_PIN is configured with pull + filter; interrupt on rising edge.
+//   • FLOW_PORT is port C, whose edge interrupts stop in EM2 on EFR32xG22:
+//     edge counting holds an EM1 requirement. PC00 is also EM4WU6
+//     (HYDRO_FLOW_EM4WU), whose level-sensitive interrupt wakes the core from
+//     EM2; the profile uses that instead.
 //
 // Watch outs / TODOs:
-//   • `seconds_since_on` increment scale implicitly depends on sampling period.
-//     If you change the period, revisit dry-run timing.
+//   • The sampling period is runtime selectable (1 s normally, down to 100 ms for
+//     streaming). Flow is always computed over the last FLOW_WINDOW_MS of pulse
+//     counts, so the L/min scale and the dry-run timing do not depend on it.
 //
 // -----------------------------------------------------------------------------
 
@@ -32,12 +57,19 @@
 #include "em_cmu.h"
 #include "sl_sleeptimer.h"
 #include "app_log.h"
+#include "loglevel.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include "gpiointerrupt.h"
 #include "em_timer.h"
+#include "em_core.h"
+#include "sl_power_manager.h"
 
 #include "app.h"
+#include "analog.h"
+#include "telemetry.h"
+#include "tlog.h"
+#include "trace.h"
 
 
 // ---- Pin layout ------------------------------------------------------------------
@@ -52,26 +84,61 @@
 
 // ---- Flow rate sensor parameter (YF-S201) ----------------------------------------
 // Calibration: Q [L/min] = F [Hz] / 5.71
-// If your specific sensor/hydraulics differ, adjust FLOW_HZ_PER_LPM accordingly.
+// If your specific sensor/hydraulics differ, adjust FLOW_HZ_PER_LPM accordingly,
+// or calibrate at runtime with hydro_set_flow_cal_x100().
 #define FLOW_HZ_PER_LPM   5.71   // 5.71 Hz == 1 L/min  (Q[L/min] = F[Hz] / 5.71)
 
 // ---- PWM parameters --------------------------------------------------------------
-// Fixed PWM duty = PWM_NUM / PWM_DEN (here 1/16 ≈ 6.25%)
+// Default PWM duty = PWM_NUM / PWM_DEN (here 1/16 ≈ 6.25%), runtime duty in ‰
 #define PWM_HZ          1000u   // 1 kHz
 #define PWM_DEN         16u
 #define PWM_NUM         1u      // 1/16 ≈ 6,25% duty
 #define PWM_TIMER         TIMER0
 #define PWM_TIMER_CLOCK   cmuClock_TIMER0
 #define PWM_CC_CH         0          // CC0
+#define PWM_SENSE_CC_CH   1          // CC1 : current-sense trigger (PRS only)
 #define PWM_FREQ_HZ       1000u
+#define DUTY_PERMILLE_DEFAULT  ((PWM_NUM * 1000u) / PWM_DEN)
+#define DUTY_PERMILLE_MAX      HYDRO_DUTY_PERMILLE_MAX
+
+// ---- Sampling --------------------------------------------------------------------
+// Flow is the pulse count over a sliding FLOW_WINDOW_MS window made of the last
+// samples, so a 100 ms period still yields a 1 s-averaged, 10 Hz-updated value.
+#define SAMPLE_MS_DEFAULT     1000u
+#define SAMPLE_MS_MIN         100u
+#define FLOW_WINDOW_MS        1000u
+#define FLOW_HIST_LEN         (FLOW_WINDOW_MS / SAMPLE_MS_MIN + 1u)
+
+// ---- Thermal control -------------------------------------------------------------
+// Coolant temperature is sampled with this period whether or not the pump runs.
+// In thermal mode the duty follows a piecewise-linear curve (fan-curve style):
+// below the first point the first duty applies, above the last point the last.
+#define THERMAL_PERIOD_MS     1000u
+
+// ---- Stop parameters -------------------------------------------------------------
+// On stop, both bridge inputs are driven HIGH for the brake window, then released.
+// A brake window of 0 keeps the old behaviour (immediate coast).
+#define BRAKE_MS_DEFAULT      150u    // active brake window [ms]
+#define BRAKE_MS_MAX          2000u   // upper bound accepted by hydro_set_brake_ms()
+// After stop the sampler keeps running until the impeller stops producing pulses.
+// If it is still spinning after this long, flow is reported as "flow while disabled".
+#define SPINDOWN_TIMEOUT_MS   5000u
 
 // ---- Internal State --------------------------------------------------------------
 // s_pulses: incremented in IRQ
 static volatile uint32_t s_pulses = 0;
+// Tick of the latest flow pulse (IRQ), used to time the spin-down after stop
+static volatile uint32_t s_last_pulse_ticks = 0;
 // Timing/compute scratch
 static uint32_t s_last_ticks = 0;
 static uint32_t s_last_pulses = 0;
 static double    s_lpm = 0.0;
+static double    s_hz_per_lpm = FLOW_HZ_PER_LPM;
+// Sampling period and pulse count history (ring) for the sliding flow window
+static uint16_t s_sample_ms = SAMPLE_MS_DEFAULT;
+static uint32_t s_hist[FLOW_HIST_LEN];
+static uint8_t  s_hist_pos = 0;
+static uint8_t  s_hist_fill = 0;   // samples taken since hist_reset()
 
 // On/off & error latch (error codes set via dry-run/flow detection logic)
 static bool     s_enabled = false;
@@ -81,6 +148,43 @@ static uint8_t  s_error   = 0;
 static double    s_min_lpm_after = 0.2; // bellow 0.2 L/min we give dry error if...
 static uint8_t  s_min_after_s   = 3;    // ...it's been the case for 3 seconds
 
+// Pump current thresholds (on-time current, see analog.c):
+static uint16_t  s_stall_ma     = 600;  // no flow above this current => seized pump
+static uint16_t  s_open_load_ma = 15;   // below this while driving => motor not connected
+static uint16_t  s_current_ma   = 0;    // latest on-time current estimate
+
+// Fault acknowledge: restart the dry-run grace period at the next sample
+static volatile bool s_ack_pending = false;
+
+// Duty: manual setting, and the value currently applied to the PWM
+static uint16_t  s_duty_manual = DUTY_PERMILLE_DEFAULT;
+static uint16_t  s_duty_permille = DUTY_PERMILLE_DEFAULT;
+static uint32_t  s_pwm_top = 0;          // TOP of the running PWM, 0 when stopped
+static bool      s_pwm_em1 = false;      // EM1 requirement held for TIMER0
+
+// Thermal mode: temperature -> duty curve (points sorted by temperature)
+static bool      s_thermal_mode = false;
+static hydro_curve_point_t s_curve[HYDRO_CURVE_MAX_POINTS] = {
+  { 3000,   DUTY_PERMILLE_DEFAULT },     // <= 30 °C : idle duty
+  { 4000,   300 },                       //    40 °C : 30 %
+  { 5000,   1000 },                      // >= 50 °C : full speed
+};
+static uint8_t   s_curve_n = 3;
+static int16_t   s_temp_c_x100 = 0;
+static bool      s_temp_valid = false;
+
+// Stop / spin-down bookkeeping
+static uint16_t  s_brake_ms = BRAKE_MS_DEFAULT;
+static bool      s_spindown = false;      // stopped, waiting for the flow to die out
+static uint32_t  s_stop_ticks = 0;        // tick when the pump was commanded off
+static uint32_t  s_stop_to_zero_ms = 0;   // last measured stop -> zero flow time
+
+// Low-power profile: thermal sampler stopped, flow edge only wakes the app
+static volatile bool s_low_power = false;
+static volatile bool s_flow_woke = false;  // flow edge seen in the profile (IRQ)
+static bool          s_monitor = false;    // off, sampling flow after a flow wake
+static bool          s_flow_edges = false; // edge counting (and its EM1) active
+
 // Optional sink callback to mirror computed telemetry to user code (debugging)
 static hydro_sink_t      s_sink = 0;
 static void             *s_sink_user = 0;
@@ -88,6 +192,8 @@ static void             *s_sink_user = 0;
 // Private timer handles (PWM via TIMER HW; sample via sleeptimer)
 static sl_sleeptimer_timer_handle_t s_pwm_tmr;
 static sl_sleeptimer_timer_handle_t s_sample_tmr;
+static sl_sleeptimer_timer_handle_t s_brake_tmr;
+static sl_sleeptimer_timer_handle_t s_thermal_tmr;
 
 // ---- Helper Functions ------------------------------------------------------------
 
@@ -99,10 +205,14 @@ static void pump_gpio_init(void)
   GPIO_PinModeSet(PUMP_PORT, PUMP_PIN_PWM, gpioModePushPull, 0); // I1A = 0 (off)
 }
 
-// Initialize and start HW PWM on TIMER0 CC0 at PWM_FREQ_HZ with duty = 1/PWM_DEN.
+// Initialize and start HW PWM on TIMER0 CC0 at PWM_FREQ_HZ with duty = s_duty_permille.
 // Chooses the smallest prescale that keeps TOP in 16-bit range.
 static void pwm_hw_start(void)
 {
+  if (!s_pwm_em1) {
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+    s_pwm_em1 = true;
+  }
   CMU_ClockEnable(PWM_TIMER_CLOCK, true);
 
   uint32_t clk = CMU_ClockFreqGet(PWM_TIMER_CLOCK);
@@ -123,8 +233,16 @@ static void pwm_hw_start(void)
   tcc.mode = timerCCModePWM;
   TIMER_InitCC(PWM_TIMER, PWM_CC_CH, &tcc);
 
+  // Compare-only channel in the middle of the on-time, not routed to a pin.
+  TIMER_InitCC_TypeDef tsense = TIMER_INITCC_DEFAULT;
+  tsense.mode = timerCCModeCompare;
+  TIMER_InitCC(PWM_TIMER, PWM_SENSE_CC_CH, &tsense);
+
+  uint32_t cmp = (top * s_duty_permille) / 1000u;
   TIMER_TopSet(PWM_TIMER, top);
-  TIMER_CompareSet(PWM_TIMER, PWM_CC_CH, top / PWM_DEN);
+  TIMER_CompareSet(PWM_TIMER, PWM_CC_CH, cmp);
+  TIMER_CompareSet(PWM_TIMER, PWM_SENSE_CC_CH, cmp / 2u);
+  s_pwm_top = top;
 
   GPIO_PinModeSet(PUMP_PORT, PUMP_PIN_PWM, gpioModePushPull, 0);
 
@@ -140,25 +258,66 @@ static void pwm_hw_start(void)
   TIMER_Enable(PWM_TIMER, true);
 }
 
-// Stop HW PWM and detach route. Also force output low for safe idle.
+// Stop HW PWM and detach route. Also force output low for safe idle, gate the
+// TIMER0 clock and drop the PWM's EM1 requirement (the flow input holds its
+// own outside the low-power profile, see flow_watch_edges()).
 static void pwm_hw_stop(void)
 {
+  s_pwm_top = 0;
   TIMER_Enable(PWM_TIMER, false);
 #if defined(GPIO_TIMER_ROUTEEN_CC0PEN)
   GPIO->TIMERROUTE[0].ROUTEEN &= ~GPIO_TIMER_ROUTEEN_CC0PEN;
 #endif
   GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_PWM);
+  CMU_ClockEnable(PWM_TIMER_CLOCK, false);
+  if (s_pwm_em1) {
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+    s_pwm_em1 = false;
+  }
+}
+
+// Apply a new duty. While running, the buffered compare registers take the
+// new value at the next period, so there is no glitch on the output.
+static void pwm_apply_duty(uint16_t permille)
+{
+  s_duty_permille = permille;
+  if (s_pwm_top == 0) return;
+
+  uint32_t cmp = (s_pwm_top * permille) / 1000u;
+  TIMER_CompareBufSet(PWM_TIMER, PWM_CC_CH, cmp);
+  TIMER_CompareBufSet(PWM_TIMER, PWM_SENSE_CC_CH, cmp / 2u);
+}
+
+// End of the brake window: release both inputs so the motor coasts.
+static void brake_end_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+  GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_PWM); // I1A=0
+  GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_LOW); // I1B=0
 }
 
 // Pump control helper. When ON: keep I1B low and start PWM on I1A.
-// When OFF: stop PWM and force both lines LOW (coast/idle).
+// When OFF: stop PWM, brake (both lines HIGH) for s_brake_ms, then coast (both LOW).
 static void pump_on(bool on)
 {
+  // A pending brake window must never overlap a fresh start.
+  (void)sl_sleeptimer_stop_timer(&s_brake_tmr);
+
   if (on) {
     GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_LOW); // I1B=0
     pwm_hw_start();
+    analog_start();
   } else {
-      pwm_hw_stop();
+    analog_stop();
+    pwm_hw_stop();
+    if (s_brake_ms > 0) {
+      GPIO_PinOutSet(PUMP_PORT, PUMP_PIN_PWM); // I1A=1
+      GPIO_PinOutSet(PUMP_PORT, PUMP_PIN_LOW); // I1B=1 -> brake
+      sl_status_t sc = sl_sleeptimer_start_timer_ms(&s_brake_tmr, s_brake_ms,
+                                                    brake_end_cb, NULL, 0, 0);
+      if (sc == SL_STATUS_OK) return;
+      LOG_ERROR(CONTROL, "BRAKE timer start failed: 0x%lx\r\n", (unsigned long)sc);
+    }
     GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_PWM); // I1A=0
     GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_LOW); // I1B=0
   }
@@ -167,11 +326,65 @@ static void pump_on(bool on)
 
 // ---- IRQ -------------------------------------------------------------------------
 
+// Low-power profile: the first edge wakes the app, which leaves the profile.
+static void flow_wake_app(void)
+{
+  if (s_low_power && !s_flow_woke) {
+    s_flow_woke = true;
+    (void)sl_bt_external_signal(SIG_POWER);
+  }
+}
+
 // Flow pulse counter interrupt callback (rising edge).
 static void flow_irq_cb(uint8_t pin)
 {
   (void)pin;
   s_pulses++;
+  s_last_pulse_ticks = sl_sleeptimer_get_tick_count();
+  TRACE(TRACE_EV_PULSE, s_pulses);
+  flow_wake_app();
+}
+
+// Switch the flow input between edge counting (EM1: port C edges stop in EM2)
+// and the EM4WU wakeup of the low-power profile (EM2). Any context.
+static void flow_watch_edges(bool edges)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (edges != s_flow_edges) {
+    s_flow_edges = edges;
+    if (edges) {
+      GPIO_EM4WUExtIntConfig(FLOW_PORT, FLOW_PIN, HYDRO_FLOW_EM4WU, false, false);
+      GPIO_PinModeSet(FLOW_PORT, FLOW_PIN, gpioModeInputPullFilter, 1);
+      GPIO_IntClear(1u << HYDRO_FLOW_EXTI);
+      GPIO_IntEnable(1u << HYDRO_FLOW_EXTI);
+      sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+    } else {
+      GPIO_IntDisable(1u << HYDRO_FLOW_EXTI);
+      // EM4WU is level sensitive: arm it for the level the input is not at,
+      // so either half of the next pulse wakes the core. The config call
+      // sets the pull from the polarity; the sensor wants the pull-up back.
+      bool high = GPIO_PinInGet(FLOW_PORT, FLOW_PIN) != 0;
+      GPIO_EM4WUExtIntConfig(FLOW_PORT, FLOW_PIN, HYDRO_FLOW_EM4WU, !high, true);
+      GPIO_PinModeSet(FLOW_PORT, FLOW_PIN, gpioModeInputPullFilter, 1);
+      sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+    }
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+// EM4WU wake of the flow input (low-power profile only): back to edge
+// counting, and count the wake itself if it was the rising half of a pulse.
+static void flow_wake_cb(uint8_t int_no, void *ctx)
+{
+  (void)int_no; (void)ctx;
+  bool high = GPIO_PinInGet(FLOW_PORT, FLOW_PIN) != 0;
+  flow_watch_edges(true);
+  if (high) {
+    flow_irq_cb(FLOW_PIN);
+  } else {
+    flow_wake_app();
+  }
 }
 
 // Configure flow input pin with pull+filter and enable rising-edge IRQ.
@@ -182,13 +395,33 @@ static void flow_gpio_init(void)
     GPIO_PinModeSet(FLOW_PORT, FLOW_PIN, gpioModeInputPullFilter, 1);
 
     // Interrupt setup, calling on rising edge
-    GPIO_ExtIntConfig(FLOW_PORT, FLOW_PIN, FLOW_PIN, true, false, true);
+    GPIO_ExtIntConfig(FLOW_PORT, FLOW_PIN, HYDRO_FLOW_EXTI, true, false, true);
 
-    GPIO_IntClear(1u << FLOW_PIN);
+    GPIO_IntClear(1u << HYDRO_FLOW_EXTI);
 
     GPIOINT_Init();
-    GPIOINT_CallbackRegister(FLOW_PIN, flow_irq_cb);
-    GPIO_IntEnable(1u << FLOW_PIN);
+    GPIOINT_CallbackRegister(HYDRO_FLOW_EXTI, flow_irq_cb);
+    GPIO_IntEnable(1u << HYDRO_FLOW_EXTI);
+    if (GPIOINT_EM4WUCallbackRegister(FLOW_PORT, FLOW_PIN, flow_wake_cb, NULL)
+        != HYDRO_FLOW_EM4WU) {
+      LOG_ERROR(CONTROL, "Flow EM4WU callback not registered\r\n");
+    }
+
+    // Edge counting until the low-power profile swaps it for the EM4WU wake.
+    s_flow_edges = true;
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+}
+
+// Fill the flow window with the current count: flow restarts from zero, and
+// the window grows back to FLOW_WINDOW_MS one sample at a time.
+static void hist_reset(void)
+{
+  uint32_t p = s_pulses;
+  for (uint32_t i = 0; i < FLOW_HIST_LEN; i++) s_hist[i] = p;
+  s_last_pulses = p;
+  s_hist_fill = 0;
+  // A partial batch from before the gap would get a wrapped u16 offset.
+  telemetry_batch_restart();
 }
 
 // ---- Callback function to calculate the L/min value and set signals --------------
@@ -203,49 +436,150 @@ static void sample_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
   uint32_t p = s_pulses;
   __enable_irq();
 
-  double dp = p - s_last_pulses;
+  // Pulses over the sliding window: compare with the snapshot taken
+  // n = FLOW_WINDOW_MS / s_sample_ms samples ago (s_hist_pos is the previous
+  // sample, i.e. 1 period ago). Right after hist_reset() every older entry
+  // holds the reset count, so the difference only covers the s_hist_fill
+  // periods since then, and is divided by that time instead.
+  uint32_t n = FLOW_WINDOW_MS / s_sample_ms;
+  uint32_t old = s_hist[(s_hist_pos + FLOW_HIST_LEN + 1u - n) % FLOW_HIST_LEN];
+  s_hist_pos = (uint8_t)((s_hist_pos + 1u) % FLOW_HIST_LEN);
+  s_hist[s_hist_pos] = p;
   s_last_pulses = p;
+  if (s_hist_fill < n) s_hist_fill++;
 
-  // Convert pulses per sampling period to L/min.
-  // Assumes sampling period is 1 second so that dp ≈ Hz.
-  // If sampling period != 1 s, scale dp by (1 / period_s)
-  s_lpm = dp / FLOW_HZ_PER_LPM;
+  double dp = p - old;
 
-  // Dry run detection. Every 0.25 seconds, reset counter
-  static uint8_t seconds_since_on = 0;
+  // Convert pulses per window to L/min (dp / window_s = Hz).
+  s_lpm = (dp * 1000.0 / (double)(s_hist_fill * s_sample_ms)) / s_hz_per_lpm;
+
+  // Dry run detection: time since the pump was switched on
+  static uint32_t ms_since_on = 0;
+  if (s_ack_pending) {
+    s_ack_pending = false;
+    ms_since_on = 0;
+  }
   if (s_enabled) {
-    if (seconds_since_on < 250) seconds_since_on++;
+    if (ms_since_on < 0xFFFF0000u) ms_since_on += s_sample_ms;
   } else {
-    seconds_since_on = 0;
+    ms_since_on = 0;
   }
 
+  // Spin-down after stop: the impeller counts as stopped once a whole flow
+  // window passed without a pulse. The stop time is taken from the last pulse
+  // timestamp, so it is not quantized to the sampling period.
+  uint32_t since_stop_ms = 0;
+  bool spun_down = false;
+  if (!s_enabled && s_spindown) {
+    since_stop_ms = sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count() - s_stop_ticks);
+    if (dp == 0) {
+      int32_t d = (int32_t)(s_last_pulse_ticks - s_stop_ticks);
+      s_stop_to_zero_ms = (d > 0) ? sl_sleeptimer_tick_to_ms((uint32_t)d) : 0;
+      s_spindown = false;
+      spun_down = true;
+      TLOG("Stop -> zero flow: %lu ms (brake %u ms)\r\n", s_stop_to_zero_ms, s_brake_ms);
+    }
+  } else if (!s_enabled && s_monitor && dp == 0) {
+    // Flow that woke the low-power profile has died out.
+    s_monitor = false;
+    spun_down = true;
+  }
+
+  // Pump current, only meaningful while the bridge is driven
+  bool have_ma = s_enabled && analog_get_pump_current_ma(&s_current_ma);
+  if (!have_ma) s_current_ma = 0;
+
   // Give error
-  if (s_enabled && seconds_since_on >= s_min_after_s && s_lpm < s_min_lpm_after) {
-    // the pump is on and the flow rate is bellow the minimum threshold
-    // send the error of dryrun
-    shared_set_err(1);
-  } else if (!s_enabled) {
-    shared_set_err(0);
-  } else if (!s_enabled && s_lpm > s_min_lpm_after) {
-    // flow detection when disabled
-    shared_set_err(2);
+  if (s_enabled) {
+    if (ms_since_on >= s_min_after_s * 1000u) {
+      if (have_ma && s_duty_permille > 0 && s_current_ma < s_open_load_ma) {
+        // driving, but no current flows: motor/wiring open
+        shared_set_err(HYDRO_ERR_OPEN_LOAD);
+      } else if (s_lpm < s_min_lpm_after) {
+        // the pump is on and the flow rate is bellow the minimum threshold:
+        // a seized impeller draws high current, an empty loop does not
+        shared_set_err((have_ma && s_current_ma >= s_stall_ma) ? HYDRO_ERR_STALL
+                                                               : HYDRO_ERR_DRY_RUN);
+      }
+    }
+  } else if ((s_monitor || (s_spindown && since_stop_ms >= SPINDOWN_TIMEOUT_MS))
+             && s_lpm > s_min_lpm_after) {
+    // flow detection when disabled (still flowing long after the brake, or
+    // flowing again while the pump is off)
+    shared_set_err(HYDRO_ERR_FLOW_WHILE_OFF);
+  } else {
+    shared_set_err(HYDRO_ERR_NONE);
   }
 
   // Report flow scaled by 100 (fixed-point for BLE/transport)
   uint16_t flow_x100 = (uint16_t)(s_lpm * 100.0 + 0.5);
   shared_set_flow_x100(flow_x100);
+  bool publish = telemetry_record(flow_x100, p, s_duty_permille, shared_get_err());
+  TRACE(TRACE_EV_TIME, sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count()));
+  TRACE(TRACE_EV_SAMPLE, flow_x100 | ((uint32_t)shared_get_err() << 16)
+                         | ((uint32_t)publish << 24));
+  bool flush   = telemetry_batch_append();
 
   // Notify BLE stack via external signal; OR multiple bits if needed.
-    uint32_t bits = SIG_FLOW | SIG_ERR;   //in case of more signals, logical OR them
+  // Unchanged samples (within deadband, same faults) are not signalled at all.
+  uint32_t bits = 0;
+  if (publish) bits |= SIG_FLOW | SIG_ERR;   //in case of more signals, logical OR them
+  if (flush)   bits |= SIG_BATCH;            // a streaming batch is ready
+  if (spun_down) bits |= SIG_POWER;          // idle again: low-power profile may resume
+  if (bits) {
     (void)sl_bt_external_signal(bits);    //send an external signal to the BLE stack to process
+  }
 
 
   if (s_sink) {
     s_sink(shared_get_flow_x100()/100, p, shared_get_err(), s_sink_user);
   }
+
+  // Last sample of a stop sequence: nothing left to measure.
+  if (spun_down) {
+    (void)sl_sleeptimer_stop_timer(&s_sample_tmr);
+    telemetry_batch_restart();
+  }
+}
+
+
+
+// ---- Thermal loop ----------------------------------------------------------------
+
+// Duty for a temperature: linear interpolation between the curve points.
+static uint16_t curve_duty(int16_t t)
+{
+  if (t <= s_curve[0].temp_c_x100) return s_curve[0].duty_permille;
+  for (uint8_t i = 1; i < s_curve_n; i++) {
+    const hydro_curve_point_t *a = &s_curve[i - 1];
+    const hydro_curve_point_t *b = &s_curve[i];
+    if (t <= b->temp_c_x100) {
+      int32_t span = b->temp_c_x100 - a->temp_c_x100;
+      int32_t d = (int32_t)b->duty_permille - (int32_t)a->duty_permille;
+      return (uint16_t)(a->duty_permille + (d * (t - a->temp_c_x100)) / span);
+    }
+  }
+  return s_curve[s_curve_n - 1].duty_permille;
 }
 
+// Periodic temperature sampler: reads the previous conversions, starts the
+// next one, and in thermal mode moves the duty along the curve. Without a
+// valid reading (NTC open/short) it fails safe to the hottest curve point.
+static void thermal_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+
+  int16_t t;
+  s_temp_valid = analog_get_temp_c_x100(&t);
+  if (s_temp_valid) s_temp_c_x100 = t;
+  analog_temp_trigger();
 
+  if (!s_thermal_mode) return;
+
+  uint16_t duty = s_temp_valid ? curve_duty(s_temp_c_x100)
+                               : s_curve[s_curve_n - 1].duty_permille;
+  if (duty != s_duty_permille) pwm_apply_duty(duty);
+}
 
 // ---- PUBLIC ----------------------------------------------------------------------
 
@@ -256,7 +590,13 @@ void hydro_init(void)
   if (inited) return;
   pump_gpio_init();
   flow_gpio_init();
+  analog_init();
   s_last_ticks = sl_sleeptimer_get_tick_count();
+
+  analog_temp_trigger();
+  sl_status_t sc = sl_sleeptimer_start_periodic_timer_ms(&s_thermal_tmr, THERMAL_PERIOD_MS,
+                                                         thermal_cb, NULL, 0, 0);
+  LOG_DEBUG(CONTROL, "THERMAL timer start: 0x%lx\n", (unsigned long)sc);
   inited = true;
 }
 
@@ -269,29 +609,199 @@ void hydro_enable(bool on)
 
   s_enabled = on;
   pump_on(on);
+  TRACE(TRACE_EV_ENABLE, (uint32_t)on | ((uint32_t)s_duty_permille << 16));
+  // The low-power profile follows the pump state (BLE task, SIG_POWER).
+  (void)sl_bt_external_signal(SIG_POWER);
 
   if (on) {
       sl_status_t sc;
-      // Sample frequency set to 1 Hz
-      sc = sl_sleeptimer_start_periodic_timer_ms(&s_sample_tmr, 1000, sample_cb, NULL, 0, 0);
-      app_log("SAMPLE timer start: 0x%lx\n", (unsigned long)sc);
+      // The sampler may still be running from the previous spin-down.
+      s_spindown = false;
+      s_monitor = false;
+      (void)sl_sleeptimer_stop_timer(&s_sample_tmr);
+      // Sample frequency: 1 Hz, or faster while streaming
+      hist_reset();
+      sc = sl_sleeptimer_start_periodic_timer_ms(&s_sample_tmr, s_sample_ms, sample_cb, NULL, 0, 0);
+      LOG_DEBUG(CONTROL, "SAMPLE timer start: 0x%lx\n", (unsigned long)sc);
 
-      s_last_pulses = s_pulses;
       s_error = 0;
     } else {
-        // Stop timers and force PWM pin low to fully disable drive
+      // Keep sampling until the impeller has stopped (see sample_cb); the
+      // brake window owns the pump pins from here on.
       (void)sl_sleeptimer_stop_timer(&s_pwm_tmr);
-      (void)sl_sleeptimer_stop_timer(&s_sample_tmr);
-      GPIO_PinOutClear(PUMP_PORT, PUMP_PIN_PWM);
+      s_stop_ticks = sl_sleeptimer_get_tick_count();
+      s_spindown = true;
     }
 }
 
 // Lightweight accessors for status/telemetry
 bool hydro_is_enabled(void) { return s_enabled; }
 
+// Nothing to measure: pump off, spin-down over and no flow seen since.
+bool hydro_is_idle(void)
+{
+  return !s_enabled && !s_spindown && !s_monitor && !s_flow_woke;
+}
+
+// Low-power profile. Entering stops the thermal sampler (the last temperature
+// is kept) and arms the flow input's EM2 wakeup; leaving restores edge
+// counting (the wake ISR may already have), restarts the sampler and, if a
+// flow edge woke the profile, samples the flow until it stops again
+// (flow-while-off detection).
+void hydro_set_low_power(bool on)
+{
+  if (on == s_low_power) return;
+  s_low_power = on;
+
+  if (on) {
+    (void)sl_sleeptimer_stop_timer(&s_thermal_tmr);
+    flow_watch_edges(false);
+    return;
+  }
+
+  flow_watch_edges(true);
+
+  analog_temp_trigger();
+  sl_status_t sc = sl_sleeptimer_start_periodic_timer_ms(&s_thermal_tmr, THERMAL_PERIOD_MS,
+                                                         thermal_cb, NULL, 0, 0);
+  if (sc != SL_STATUS_OK) {
+    LOG_ERROR(CONTROL, "THERMAL timer start failed: 0x%lx\r\n", (unsigned long)sc);
+  }
+  if (s_flow_woke) {
+    s_flow_woke = false;
+    if (!s_enabled && !s_spindown) {
+      s_monitor = true;
+      (void)sl_sleeptimer_stop_timer(&s_sample_tmr);
+      hist_reset();
+      sc = sl_sleeptimer_start_periodic_timer_ms(&s_sample_tmr, s_sample_ms, sample_cb, NULL, 0, 0);
+      LOG_DEBUG(CONTROL, "SAMPLE timer start (flow while off): 0x%lx\r\n", (unsigned long)sc);
+    }
+  }
+}
+
 float hydro_get_flow_lpm(void) { return s_lpm; }
 uint32_t hydro_get_pulse_count(void) { return s_pulses; }
 
+// Latest pump on-time current estimate [mA] (0 while stopped).
+uint16_t hydro_get_current_ma(void) { return s_current_ma; }
+
+// PWM duty in ‰. The manual value is used whenever thermal mode is off.
+void hydro_set_duty_permille(uint16_t permille)
+{
+  if (permille > DUTY_PERMILLE_MAX) permille = DUTY_PERMILLE_MAX;
+  s_duty_manual = permille;
+  if (!s_thermal_mode) pwm_apply_duty(permille);
+}
+uint16_t hydro_get_duty_permille(void) { return s_duty_permille; }
+
+// Coolant temperature [0.01 °C]; false if no valid NTC reading.
+bool hydro_get_temp_c_x100(int16_t *t)
+{
+  *t = s_temp_c_x100;
+  return s_temp_valid;
+}
+
+// Thermal mode on: duty follows the curve from the next thermal sample.
+// Off: the manual duty is restored.
+void hydro_set_thermal_mode(bool on)
+{
+  s_thermal_mode = on;
+  if (!on) pwm_apply_duty(s_duty_manual);
+}
+bool hydro_get_thermal_mode(void) { return s_thermal_mode; }
+
+// Replace the temperature -> duty curve. Points must be sorted by strictly
+// increasing temperature; invalid curves are rejected.
+bool hydro_set_thermal_curve(const hydro_curve_point_t *pts, uint8_t n)
+{
+  if (n == 0 || n > HYDRO_CURVE_MAX_POINTS) return false;
+  for (uint8_t i = 0; i < n; i++) {
+    if (pts[i].duty_permille > DUTY_PERMILLE_MAX) return false;
+    if (i > 0 && pts[i].temp_c_x100 <= pts[i - 1].temp_c_x100) return false;
+  }
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();   // thermal_cb() may interpolate concurrently
+  for (uint8_t i = 0; i < n; i++) s_curve[i] = pts[i];
+  s_curve_n = n;
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+// Sampling period [ms], SAMPLE_MS_MIN..FLOW_WINDOW_MS. A running sampler is
+// restarted with the new period; the flow window itself stays FLOW_WINDOW_MS.
+void hydro_set_sample_period_ms(uint16_t ms)
+{
+  if (ms < SAMPLE_MS_MIN) ms = SAMPLE_MS_MIN;
+  if (ms > FLOW_WINDOW_MS) ms = FLOW_WINDOW_MS;
+  if (ms == s_sample_ms) return;
+
+  bool running = false;
+  (void)sl_sleeptimer_is_timer_running(&s_sample_tmr, &running);
+  (void)sl_sleeptimer_stop_timer(&s_sample_tmr);
+  s_sample_ms = ms;
+  if (running) {
+    hist_reset();
+    (void)sl_sleeptimer_start_periodic_timer_ms(&s_sample_tmr, s_sample_ms, sample_cb, NULL, 0, 0);
+  }
+}
+uint16_t hydro_get_sample_period_ms(void) { return s_sample_ms; }
+
+// Active brake window applied on stop; 0 disables braking (plain coast).
+void hydro_set_brake_ms(uint16_t ms)
+{
+  s_brake_ms = (ms > BRAKE_MS_MAX) ? BRAKE_MS_MAX : ms;
+}
+uint16_t hydro_get_brake_ms(void) { return s_brake_ms; }
+
+// Fault thresholds, replaced as one set so sample_cb never sees a mix of old
+// and new values.
+void hydro_set_limits(const hydro_limits_t *l)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_min_lpm_after = l->dry_lpm_x100 / 100.0;
+  s_min_after_s   = l->dry_after_s;
+  s_stall_ma      = l->stall_ma;
+  s_open_load_ma  = l->open_load_ma;
+  CORE_EXIT_CRITICAL();
+}
+
+void hydro_get_limits(hydro_limits_t *l)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  l->dry_lpm_x100 = (uint16_t)(s_min_lpm_after * 100.0 + 0.5);
+  l->dry_after_s  = s_min_after_s;
+  l->stall_ma     = s_stall_ma;
+  l->open_load_ma = s_open_load_ma;
+  CORE_EXIT_CRITICAL();
+}
+
+// Flow sensor calibration in 0.01 Hz per L/min (571 = YF-S201 default).
+bool hydro_set_flow_cal_x100(uint16_t hz_per_lpm_x100)
+{
+  if (hz_per_lpm_x100 < HYDRO_FLOW_CAL_X100_MIN || hz_per_lpm_x100 > HYDRO_FLOW_CAL_X100_MAX) {
+    return false;
+  }
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_hz_per_lpm = hz_per_lpm_x100 / 100.0;
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+uint16_t hydro_get_flow_cal_x100(void) { return (uint16_t)(s_hz_per_lpm * 100.0 + 0.5); }
+
+// Clear the reported faults; dry-run detection starts its grace period again,
+// so a persisting condition is reported anew after s_min_after_s.
+void hydro_ack_faults(void)
+{
+  s_ack_pending = true;
+  shared_set_err(HYDRO_ERR_NONE);
+}
+
+// Time from the stop command to the last flow pulse, measured on the last stop.
+uint32_t hydro_get_stop_to_zero_ms(void) { return s_stop_to_zero_ms; }
+
 // Register/unregister sink callback to receive live updates from sample_cb.
 void hydro_set_sink(hydro_sink_t cb, void *user)
 {
@@ -7,6 +7,35 @@
 // Minden új mintánál hívjuk: lpm, pulses, error_code (0=OK, !0 hiba)
 typedef void (*hydro_sink_t)(float lpm, uint32_t pulses, uint8_t error_code, void *user);
 
+// Hibakódok (error_code / shared_get_err() bitjei)
+#define HYDRO_ERR_NONE            0u
+#define HYDRO_ERR_DRY_RUN         (1u << 0)  // bekapcsolva, nincs átfolyás, normál áram
+#define HYDRO_ERR_FLOW_WHILE_OFF  (1u << 1)  // kikapcsolva is van átfolyás
+#define HYDRO_ERR_STALL           (1u << 2)  // nincs átfolyás, magas áram (beragadt)
+#define HYDRO_ERR_OPEN_LOAD       (1u << 3)  // hajtás alatt nincs áram (szakadás)
+
+// Hőmérséklet -> kitöltés görbe egy pontja (ventilátor görbe jelleggel)
+#define HYDRO_CURVE_MAX_POINTS  4
+#define HYDRO_DUTY_PERMILLE_MAX 1000u
+typedef struct {
+  int16_t  temp_c_x100;    // hőmérséklet [0.01 °C]
+  uint16_t duty_permille;  // kitöltés [‰]
+} hydro_curve_point_t;
+
+// Hibadetektálási küszöbök (egy egységként cserélhetők)
+typedef struct {
+  uint16_t dry_lpm_x100;   // szárazfutás: ez alatti átfolyás [0.01 L/min]...
+  uint8_t  dry_after_s;    // ...ennyi idővel bekapcsolás után [s]
+  uint16_t stall_ma;       // nincs átfolyás és e feletti áram => beragadt
+  uint16_t open_load_ma;   // hajtás alatt e alatti áram => szakadás
+} hydro_limits_t;
+
+// Átfolyás bemenet GPIO külső megszakítás száma (energy.c ébresztés forrás)
+#define HYDRO_FLOW_EXTI         0u
+// Az átfolyás bemenet (PC00) EM4WU száma: az alacsony fogyasztású profilban
+// ezen keresztül ébreszt EM2-ből (energy.c ébresztés forrás)
+#define HYDRO_FLOW_EM4WU        6u
+
 // Init: GPIO + IRQ + belső állapot
 void hydro_init(void);
 
@@ -14,9 +43,56 @@ void hydro_init(void);
 void hydro_enable(bool on);
 bool hydro_is_enabled(void);
 
+// Nincs mit mérni: pumpa ki, a lefutás véget ért, azóta nem volt átfolyás
+bool hydro_is_idle(void);
+// Alacsony fogyasztású profil (lowpower.c, BLE task): a hőmérséklet mintavétel
+// áll (az utolsó érték marad), az átfolyás bemenet első éle SIG_POWER jelet
+// küld. A profilban a bemenet EM4WU ébresztésként figyel (EM2, a control.c
+// EM1 igénye elengedve), az ébredéskor visszaáll az élszámlálás és az EM1.
+// Kilépéskor ilyen ébresztés után a mintavétel addig fut, amíg az átfolyás
+// meg nem áll (átfolyás kikapcsolt pumpánál hiba).
+void hydro_set_low_power(bool on);
+
 // Aktuális értékek lekérdezése
 float    hydro_get_flow_lpm(void);
 uint32_t hydro_get_pulse_count(void);
+// Szivattyú áram becslés a PWM bekapcsolt szakaszában [mA]
+uint16_t hydro_get_current_ma(void);
+
+// PWM kitöltés [‰] (kézi érték; termikus módban a görbe felülírja)
+void     hydro_set_duty_permille(uint16_t permille);
+uint16_t hydro_get_duty_permille(void);
+
+// Hűtőfolyadék hőmérséklet [0.01 °C]; false, ha nincs érvényes NTC mérés
+bool hydro_get_temp_c_x100(int16_t *t);
+
+// Termikus mód: a kitöltést a hőmérséklet -> kitöltés görbe adja
+void hydro_set_thermal_mode(bool on);
+bool hydro_get_thermal_mode(void);
+// Görbe csere (pontok szigorúan növekvő hőmérséklet szerint); false, ha érvénytelen
+bool hydro_set_thermal_curve(const hydro_curve_point_t *pts, uint8_t n);
+
+// Mintavételi periódus [ms] (100..1000; streaming módban 100 ms = 10 Hz).
+// Az átfolyás mindig az utolsó 1 s impulzusaiból számolódik.
+void     hydro_set_sample_period_ms(uint16_t ms);
+uint16_t hydro_get_sample_period_ms(void);
+
+// Leállításkori aktív fékezés ablaka [ms] (0 = azonnali szabadonfutás)
+void     hydro_set_brake_ms(uint16_t ms);
+uint16_t hydro_get_brake_ms(void);
+// Utolsó leállításnál mért idő a stop parancstól a nulla átfolyásig [ms]
+uint32_t hydro_get_stop_to_zero_ms(void);
+
+// Hibadetektálási küszöbök
+void hydro_set_limits(const hydro_limits_t *l);
+void hydro_get_limits(hydro_limits_t *l);
+// Átfolyásmérő kalibráció [0.01 Hz / (L/min)]; false, ha tartományon kívül
+#define HYDRO_FLOW_CAL_X100_MIN  10u
+#define HYDRO_FLOW_CAL_X100_MAX  10000u
+bool     hydro_set_flow_cal_x100(uint16_t hz_per_lpm_x100);
+uint16_t hydro_get_flow_cal_x100(void);
+// Hibák nyugtázása (törli a hibaállapotot, a szárazfutás figyelés újraindul)
+void hydro_ack_faults(void);
 
 // App oldali "1 soros" GATT küldés beregisztrálása
 void hydro_set_sink(hydro_sink_t cb, void *user);
@@ -0,0 +1,240 @@
+// -----------------------------------------------------------------------------
+// energy.c — Energy mode residency and wakeup source accounting
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Accumulate the time spent in EM0, EM1 and EM2 from the power manager's
+//     transition events, timed with the sleeptimer counter (it keeps running
+//     in EM2, unlike the CPU cycle counter).
+//   • Attribute every wakeup to one source: flow pulse, other GPIO (button),
+//     radio, sleeptimer, VCOM USART (including the log LDMA channel), or
+//     "other".
+//   • Log the residency and wakeups of the last window under the POWER module
+//     (at WARNING, so the report is on with the boot log level) and serve the
+//     totals to the Energy Stats characteristic.
+//
+// Concurrency model & safety notes:
+//   • on_transition() runs inside the power manager's critical section, on the
+//     way into sleep and right after waking up, before the interrupt that woke
+//     the core has been taken. Its NVIC pending bit is therefore still set and
+//     identifies the source without hooks in the drivers. A source whose IRQ
+//     is above the critical section's BASEPRI level may already have run; such
+//     a wakeup is counted as ENERGY_WAKE_OTHER.
+//   • Readers (BLE task, app_process_action) copy the counters in a critical
+//     section and add the running EM0 interval themselves.
+//   • The periodic log piggybacks on app_process_action, so it never wakes the
+//     device on its own; a window may end up longer while the device sleeps.
+//
+// Hardware assumptions:
+//   • EFR32BG22: the sleeptimer runs on RTCC (or BURTC), the radio wakes the
+//     core from EM2 through PRORTC, VCOM is USART1 and log output uses LDMA.
+//     LDMA has a single IRQ for all channels; LDMA->IF tells them apart.
+//
+// -----------------------------------------------------------------------------
+
+#include "energy.h"
+#include "control.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "logtx.h"
+#include "em_core.h"
+#include "em_device.h"
+#include "em_gpio.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+
+#define ENERGY_EM_COUNT   3u   // EM0, EM1, EM2 (EM3 is added to EM2)
+
+// ---- Internal State --------------------------------------------------------------
+typedef struct {
+  uint64_t em_ticks[ENERGY_EM_COUNT];
+  uint32_t sleeps;
+  uint32_t wakeups[ENERGY_WAKE_COUNT];
+} energy_acc_t;
+
+static energy_acc_t s_acc;
+static uint8_t  s_em = 0;          // current energy mode bucket
+static uint32_t s_since = 0;       // tick count at the last transition
+static uint64_t s_boot_ticks = 0;  // tick count when accounting started
+
+static energy_acc_t s_logged;      // totals at the last periodic log
+static uint64_t s_logged_ticks = 0;
+
+static sl_power_manager_em_transition_event_handle_t s_pm_handle;
+
+static void on_transition(sl_power_manager_em_t from, sl_power_manager_em_t to);
+
+static const sl_power_manager_em_transition_event_info_t s_pm_info = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0
+                | SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM1
+                | SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2
+                | SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM3,
+  .on_event   = on_transition,
+};
+
+static const char *const s_wake_names[ENERGY_WAKE_COUNT] = {
+  "flow", "button", "radio", "timer", "usart", "other"
+};
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static uint8_t em_bucket(sl_power_manager_em_t em)
+{
+  return (em >= SL_POWER_MANAGER_EM2) ? 2u : (uint8_t)em;
+}
+
+static bool pending(IRQn_Type irq)
+{
+  return NVIC_GetPendingIRQ(irq) != 0;
+}
+
+// Source of the wakeup in progress; called before its IRQ is taken.
+static uint8_t wake_source(void)
+{
+  if (pending(GPIO_ODD_IRQn) || pending(GPIO_EVEN_IRQn)) {
+    uint32_t flags = GPIO_IntGet() & GPIO_IntGetEnabled();
+    uint32_t flow = (1u << HYDRO_FLOW_EXTI)
+                    | (1u << (_GPIO_IF_EM4WU_SHIFT + HYDRO_FLOW_EM4WU));
+    return (flags & flow) ? ENERGY_WAKE_FLOW : ENERGY_WAKE_BUTTON;
+  }
+  if (pending(PRORTC_IRQn) || pending(PROTIMER_IRQn) || pending(RAC_SEQ_IRQn)
+      || pending(RAC_RSM_IRQn) || pending(FRC_IRQn) || pending(FRC_PRI_IRQn)
+      || pending(MODEM_IRQn) || pending(AGC_IRQn) || pending(BUFC_IRQn)
+      || pending(SYNTH_IRQn)) {
+    return ENERGY_WAKE_RADIO;
+  }
+  if (pending(RTCC_IRQn) || pending(BURTC_IRQn)) {
+    return ENERGY_WAKE_SLEEPTIMER;
+  }
+  if (pending(USART1_RX_IRQn) || pending(USART1_TX_IRQn)) {
+    return ENERGY_WAKE_USART;
+  }
+  if (pending(LDMA_IRQn)) {
+    // One IRQ for every LDMA channel, the IADC ones (analog.c) included:
+    // only the log channel's done flag makes it a VCOM wakeup.
+    int ch = logtx_dma_channel();
+    if (ch >= 0 && (LDMA->IF & (1u << (unsigned)ch)) != 0) return ENERGY_WAKE_USART;
+  }
+  return ENERGY_WAKE_OTHER;
+}
+
+static void on_transition(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint32_t now = sl_sleeptimer_get_tick_count();
+
+  s_acc.em_ticks[em_bucket(from)] += (uint32_t)(now - s_since);
+  s_since = now;
+  s_em = em_bucket(to);
+
+  if (from == SL_POWER_MANAGER_EM0) {
+    s_acc.sleeps++;
+  } else if (to == SL_POWER_MANAGER_EM0) {
+    s_acc.wakeups[wake_source()]++;
+  }
+}
+
+// Totals up to now, including the interval of the current mode.
+static void snapshot(energy_acc_t *out, uint64_t *now_ticks)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = s_acc;
+  uint32_t now = sl_sleeptimer_get_tick_count();
+  out->em_ticks[s_em] += (uint32_t)(now - s_since);
+  *now_ticks = sl_sleeptimer_get_tick_count64();
+  CORE_EXIT_CRITICAL();
+}
+
+static uint32_t ticks_to_ms(uint64_t ticks)
+{
+  uint64_t ms = 0;
+  (void)sl_sleeptimer_tick64_to_ms(ticks, &ms);
+  return (uint32_t)ms;
+}
+
+static uint32_t permille(uint64_t part, uint64_t whole)
+{
+  return (whole != 0) ? (uint32_t)((part * 1000u) / whole) : 0;
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void energy_init(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_since = sl_sleeptimer_get_tick_count();
+  s_boot_ticks = sl_sleeptimer_get_tick_count64();
+  s_logged_ticks = s_boot_ticks;
+  s_em = 0;
+  CORE_EXIT_CRITICAL();
+
+  sl_power_manager_subscribe_em_transition_event(&s_pm_handle, &s_pm_info);
+}
+
+// The report logs at WARNING so it shows at LOG_BOOT_LEVEL; setting POWER
+// above it (CMD_TLV_LOG_LEVEL) turns it off.
+void energy_process(void)
+{
+  if (!LOG_ON(POWER, APP_LOG_LEVEL_WARNING)) return;
+
+  energy_acc_t now;
+  uint64_t now_ticks;
+  snapshot(&now, &now_ticks);
+
+  uint64_t window = now_ticks - s_logged_ticks;
+  if (ticks_to_ms(window) < ENERGY_LOG_PERIOD_MS) return;
+
+  uint64_t em[ENERGY_EM_COUNT];
+  for (uint32_t i = 0; i < ENERGY_EM_COUNT; i++) {
+    em[i] = now.em_ticks[i] - s_logged.em_ticks[i];
+  }
+  LOG_WARN(POWER, "EM0/1/2: %lu/%lu/%lu permille over %lu s, %lu sleeps\r\n",
+                  (unsigned long)permille(em[0], window),
+                  (unsigned long)permille(em[1], window),
+                  (unsigned long)permille(em[2], window),
+                  (unsigned long)(ticks_to_ms(window) / 1000u),
+                  (unsigned long)(now.sleeps - s_logged.sleeps));
+  for (uint32_t i = 0; i < ENERGY_WAKE_COUNT; i++) {
+    uint32_t n = now.wakeups[i] - s_logged.wakeups[i];
+    if (n != 0) {
+      LOG_WARN(POWER, "  wake %-6s %lu\r\n", s_wake_names[i], (unsigned long)n);
+    }
+  }
+
+  s_logged = now;
+  s_logged_ticks = now_ticks;
+}
+
+void energy_get_stats(energy_stats_t *out)
+{
+  energy_acc_t now;
+  uint64_t now_ticks;
+  snapshot(&now, &now_ticks);
+
+  out->uptime_ms = ticks_to_ms(now_ticks - s_boot_ticks);
+  for (uint32_t i = 0; i < ENERGY_EM_COUNT; i++) {
+    out->em_ms[i] = ticks_to_ms(now.em_ticks[i]);
+  }
+  out->sleeps = now.sleeps;
+  for (uint32_t i = 0; i < ENERGY_WAKE_COUNT; i++) {
+    out->wakeups[i] = now.wakeups[i];
+  }
+}
+
+size_t energy_pack_stats(const energy_stats_t *s, uint8_t *buf)
+{
+  const uint32_t v[] = {
+    s->uptime_ms, s->em_ms[0], s->em_ms[1], s->em_ms[2], s->sleeps,
+    s->wakeups[ENERGY_WAKE_FLOW], s->wakeups[ENERGY_WAKE_BUTTON],
+    s->wakeups[ENERGY_WAKE_RADIO], s->wakeups[ENERGY_WAKE_SLEEPTIMER],
+    s->wakeups[ENERGY_WAKE_USART], s->wakeups[ENERGY_WAKE_OTHER],
+  };
+  for (uint32_t i = 0; i < sizeof(v) / sizeof(v[0]); i++) {
+    buf[4 * i]     = (uint8_t)v[i];
+    buf[4 * i + 1] = (uint8_t)(v[i] >> 8);
+    buf[4 * i + 2] = (uint8_t)(v[i] >> 16);
+    buf[4 * i + 3] = (uint8_t)(v[i] >> 24);
+  }
+  return ENERGY_STATS_LEN;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Energia mód tartózkodási idő és ébresztési forrás statisztika. A power
+// manager minden EM átmenetnél hív (alvás előtt és ébredéskor, még a
+// függő megszakítás kiszolgálása előtt); az idő a sleeptimer számlálóból
+// jön (EM2-ben is jár). Az ébresztés forrása a függő NVIC megszakításokból
+// derül ki. Olvasás: Energy Stats karakterisztika, napló: POWER modul WARNING
+// szinten (az alapértelmezett LOG_BOOT_LEVEL mellett is látszik).
+// Megj.: a VCOM RX EM1 igényét a lowpower.c tartja a normál profilban; EM2
+// csak az alacsony fogyasztású profilban érhető el (ott az átfolyás bemenet és
+// a gomb EM4WU ébresztésként figyel, a control.c EM1 igénye elengedve).
+
+#define ENERGY_LOG_PERIOD_MS   60000u   // időszakos napló (ébren, nincs saját timer)
+
+// Ébresztési források (egy ébredés = egy forrás, prioritás sorrendben)
+#define ENERGY_WAKE_FLOW        0u   // átfolyás impulzus (GPIO, HYDRO_FLOW_EXTI)
+#define ENERGY_WAKE_BUTTON      1u   // egyéb GPIO (gomb)
+#define ENERGY_WAKE_RADIO       2u   // rádió / link layer (PRORTC, PROTIMER, RAC, FRC, ...)
+#define ENERGY_WAKE_SLEEPTIMER  3u   // sleeptimer (RTCC/BURTC)
+#define ENERGY_WAKE_USART       4u   // VCOM USART1 RX/TX, log LDMA csatorna
+#define ENERGY_WAKE_OTHER       5u   // nem azonosított (pl. már kiszolgált)
+#define ENERGY_WAKE_COUNT       6u
+
+typedef struct {
+  uint32_t uptime_ms;
+  uint32_t em_ms[3];                   // EM0, EM1, EM2 (+EM3) idő [ms]
+  uint32_t sleeps;                     // alvások száma (EM1 vagy mélyebb)
+  uint32_t wakeups[ENERGY_WAKE_COUNT]; // ébresztések forrásonként
+} energy_stats_t;
+
+// Energy Stats karakterisztika, little endian u32:
+//   [0] uptime_ms  [4] EM0 ms  [8] EM1 ms  [12] EM2 ms  [16] alvások
+//   [20] ébresztés: flow  [24] button  [28] radio  [32] sleeptimer
+//   [36] usart  [40] other
+#define ENERGY_STATS_LEN  44u
+
+// Boot után, minél korábban (feliratkozás az EM átmenetekre)
+void energy_init(void);
+// app_process_action-ből: ENERGY_LOG_PERIOD_MS-enként napló az ablakról
+void energy_process(void);
+
+void   energy_get_stats(energy_stats_t *out);
+size_t energy_pack_stats(const energy_stats_t *s, uint8_t *buf);
@@ -0,0 +1,179 @@
+// -----------------------------------------------------------------------------
+// gatt_read.c — On-demand values of the user type characteristics
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Serve reads of the read-mostly characteristics (flow rate, error state,
+//     link parameters, TX queue stats, advertising state, diagnostics, energy
+//     stats) straight from live state. Nothing is copied into the GATT
+//     database on the update paths; the work is done only when a client
+//     actually reads.
+//   • Handle long values: the stack sends at most ATT_MTU - 1 bytes per
+//     response, the client continues with read blob requests at an offset, and
+//     every request rebuilds the value and answers from that offset.
+//   • Answer per connection where the value is per connection (Link Parameters
+//     returns the reader's own link).
+//
+// Concurrency model & safety notes:
+//   • Everything runs in BLE task context (sl_bt_on_event).
+//   • A long value is rebuilt for every blob request, so counters may move
+//     between two parts of one long read; each u32 is still consistent.
+//
+// -----------------------------------------------------------------------------
+
+#include "gatt_read.h"
+#include "app.h"
+#include "adv.h"
+#include "bthome.h"
+#include "control.h"
+#include "energy.h"
+#include "link.h"
+#include "logtx.h"
+#include "padv.h"
+#include "telemetry.h"
+#include "txpwr.h"
+#include "gatt_db.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "sl_bluetooth.h"
+#include "sl_sleeptimer.h"
+
+// ATT error codes
+#define ATT_ERR_INVALID_OFFSET     0x07u
+#define ATT_ERR_ATTR_NOT_FOUND     0x0Au
+
+#define GATT_READ_MAX_LEN          GATT_READ_DIAG_LEN   // longest value served here
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+  return p + 4;
+}
+
+static uint32_t avg(uint32_t sum, uint32_t count)
+{
+  return (count != 0) ? sum / count : 0;
+}
+
+static size_t build_diag(uint8_t *buf)
+{
+  telemetry_stats_t ts;
+  telemetry_batch_stats_t bs;
+  bthome_crypto_stats_t cs;
+  padv_stats_t ps;
+  link_first_notify_stats_t fresh, bonded;
+  txpwr_stats_t tp;
+  logtx_stats_t ls;
+
+  telemetry_get_stats(&ts);
+  telemetry_batch_get_stats(&bs);
+  bthome_get_crypto_stats(&cs);
+  padv_get_stats(&ps);
+  link_get_first_notify_stats(false, &fresh);
+  link_get_first_notify_stats(true, &bonded);
+  txpwr_get_stats(&tp);
+  logtx_get_stats(&ls);
+
+  uint8_t *p = buf;
+  p = put_u32(p, sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count()));
+  p = put_u32(p, hydro_get_pulse_count());
+  p = put_u32(p, hydro_get_stop_to_zero_ms());
+  p = put_u32(p, ts.sent);
+  p = put_u32(p, ts.suppressed);
+  p = put_u32(p, bs.batches);
+  p = put_u32(p, bs.records);
+  p = put_u32(p, bs.overruns);
+  p = put_u32(p, cs.count);
+  p = put_u32(p, cs.last_us);
+  p = put_u32(p, cs.max_us);
+  p = put_u32(p, cs.avg_us);
+  p = put_u32(p, ps.updates);
+  p = put_u32(p, ps.unchanged);
+  p = put_u32(p, ps.bytes_written);
+  p = put_u32(p, fresh.count);
+  p = put_u32(p, fresh.last_ms);
+  p = put_u32(p, avg(fresh.sum_ms, fresh.count));
+  p = put_u32(p, bonded.count);
+  p = put_u32(p, bonded.last_ms);
+  p = put_u32(p, avg(bonded.sum_ms, bonded.count));
+  p = put_u32(p, (uint32_t)(int32_t)tp.level_x10);
+  p = put_u32(p, (uint32_t)(int32_t)tp.avg_level_x10);
+  p = put_u32(p, tp.pc_saved_permille);
+  p = put_u32(p, ls.dropped);
+  return (size_t)(p - buf);
+}
+
+// Current value of a user characteristic; 0 if not served here.
+static size_t build_value(uint8_t connection, uint16_t characteristic, uint8_t *buf)
+{
+  switch (characteristic) {
+    case gattdb_flow_rate: {
+      uint16_t v = shared_get_flow_x100();
+      buf[0] = (uint8_t)v;
+      buf[1] = (uint8_t)(v >> 8);
+      return 2;
+    }
+    case gattdb_send_error:
+      buf[0] = shared_get_err();
+      return 1;
+    case gattdb_link_params: {
+      link_params_t params;
+      if (!link_get_params(connection, &params)) return 0;
+      return link_pack_params(&params, buf);
+    }
+    case gattdb_tx_queue_stats: {
+      link_txq_stats_t stats;
+      link_get_txq_stats(&stats);
+      return link_pack_txq_stats(&stats, buf);
+    }
+    case gattdb_adv_state: {
+      uint16_t interval = adv_get_interval_ms();
+      buf[0] = adv_get_stage();
+      buf[1] = (uint8_t)interval;
+      buf[2] = (uint8_t)(interval >> 8);
+      return 3;
+    }
+    case gattdb_diagnostics:
+      return build_diag(buf);
+    case gattdb_energy_stats: {
+      energy_stats_t stats;
+      energy_get_stats(&stats);
+      return energy_pack_stats(&stats, buf);
+    }
+    default:
+      return 0;
+  }
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void gatt_read_request(uint8_t connection, uint16_t characteristic,
+                       uint8_t att_opcode, uint16_t offset)
+{
+  (void)att_opcode;   // read and read blob are answered the same way
+  uint8_t buf[GATT_READ_MAX_LEN];
+  uint16_t sent = 0;
+  uint8_t att_err = 0;
+
+  size_t len = build_value(connection, characteristic, buf);
+  if (len == 0) {
+    att_err = ATT_ERR_ATTR_NOT_FOUND;
+  } else if (offset > len) {
+    att_err = ATT_ERR_INVALID_OFFSET;
+  }
+  if (att_err != 0) len = offset = 0;
+
+  // The stack truncates to ATT_MTU - 1; the client reads on with an offset.
+  sl_status_t sc = sl_bt_gatt_server_send_user_read_response(connection, characteristic,
+                                                             att_err, len - offset,
+                                                             &buf[offset], &sent);
+  if (sc != SL_STATUS_OK) {
+    LOG_WARN(BLE, "User read 0x%04x failed sc=0x%04lx\r\n",
+                  (unsigned)characteristic, (unsigned long)sc);
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+
+// User típusú (olvasás-közeli) karakterisztikák: az érték nem a GATT
+// adatbázisban van, hanem olvasáskor készül az élő állapotból
+// (sl_bt_evt_gatt_server_user_read_request). Hosszú értéknél a kliens read
+// blob kérésekkel, offsettel olvas tovább.
+//
+// Diagnostics karakterisztika, little endian, u32 (ahol nincs más jelölve):
+//   [0] uptime_ms  [4] pulses (összes impulzus)  [8] stop_to_zero_ms
+//   [12] telemetry sent  [16] telemetry suppressed
+//   [20] batch batches  [24] batch records  [28] batch overruns
+//   [32] bthome count  [36] bthome last_us  [40] bthome max_us  [44] bthome avg_us
+//   [48] padv updates  [52] padv unchanged  [56] padv bytes_written
+//   [60] first notify fresh: count  [64] last_ms  [68] avg_ms
+//   [72] first notify bonded: count  [76] last_ms  [80] avg_ms
+//   [84] TX power [0.1 dBm, i32]  [88] átlag TX power kapcsolat alatt [0.1 dBm, i32]
+//   [92] becsült TX energia megtakarítás [‰]
+//   [96] log: eldobott bájtok (teli DMA gyűrű)
+#define GATT_READ_DIAG_LEN  100u
+
+// Olvasási kérés kiszolgálása (BLE task). Ismeretlen karakterisztika vagy
+// túl nagy offset esetén ATT hibával válaszol.
+void gatt_read_request(uint8_t connection, uint16_t characteristic,
+                       uint8_t att_opcode, uint16_t offset);
@@ -0,0 +1,655 @@
+// -----------------------------------------------------------------------------
+// link.c — BLE connection bookkeeping and connection parameter policy
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Track the open connections and the parameters the stack reports for
+//     each of them (interval, peripheral latency, supervision timeout).
+//   • Decide which parameter profile every connection should run with:
+//       - IDLE: long interval plus peripheral latency, so the radio wakes
+//         rarely while nothing but an occasional sample is sent;
+//       - FAST: short interval without latency, while any demand is active
+//         (streaming, bulk history download, a fault or discovery burst).
+//     The app state machine only raises or clears demands; the profile change
+//     is requested with sl_bt_connection_set_parameters() from one place.
+//   • Time-limited bursts (after a fault, after connecting) expire on a
+//     one-shot sleeptimer.
+//   • Keep the notification subscriptions per connection and characteristic,
+//     and send notifications only to the connections that subscribed. A
+//     summary mask answers "is anyone listening?" without any stack call.
+//   • Ask for the LE 2M PHY and the maximum LL data length on every new
+//     connection, so bulk transfers keep the radio on for about half as long.
+//     Both are requests: a central that declines leaves the link on 1M with
+//     27 byte PDUs, which is recorded and works as before.
+//   • Measure the effective throughput of bulk transfers (history download):
+//     payload bytes the stack accepted between link_bulk_begin() and
+//     link_bulk_end(). The API reports no per-notification TX completion, so
+//     this is the rate of queueing into the stack's TX buffers: the last few
+//     buffers are still on their way when the measurement ends, which reads
+//     high for short transfers (at most the stack's buffer depth over the
+//     transfer time).
+//   • Time connection-open to the first notification accepted by the stack,
+//     separately for bonded and fresh connections, so the gain of restored
+//     subscriptions on reconnect is measured rather than assumed.
+//   • Hold notifications the stack refused (out of TX buffers) in a small
+//     per-connection queue. For state-like characteristics a newer value
+//     replaces the queued one (coalescing), so only the latest is sent; stream
+//     batches are kept in order. The queue is retried about one connection
+//     interval later, i.e. at the next connection event.
+//
+// Concurrency model & safety notes:
+//   • Everything except burst_end_cb() runs in BLE task context.
+//   • burst_end_cb() runs from sleeptimer context; it only clears the burst
+//     bit and raises SIG_LINK, the policy then runs in link_process().
+//   • txq_retry_cb() runs from sleeptimer context and only raises SIG_TXQ;
+//     the queue is drained in link_txq_process().
+//   • A request that the stack rejects (e.g. a parameter update procedure is
+//     still pending) leaves the requested profile unchanged, so the next
+//     link_process() retries it.
+//
+// -----------------------------------------------------------------------------
+
+#include "link.h"
+#include "app.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "em_core.h"
+#include "sl_bluetooth.h"
+#include "gatt_db.h"
+#include "sl_bluetooth_connection_config.h"
+#include "sl_sleeptimer.h"
+#include "trace.h"
+
+// ---- Parameter profiles ----------------------------------------------------------
+// Intervals in 1.25 ms units, timeouts in 10 ms units. The supervision timeout
+// must exceed (1 + latency) * max_interval * 2.
+#define IDLE_INTERVAL_MIN     320u   // 400 ms
+#define IDLE_INTERVAL_MAX     400u   // 500 ms
+#define IDLE_LATENCY          3u     // may skip 3 events => ~2 s worst case
+#define IDLE_TIMEOUT          600u   // 6 s
+
+#define FAST_INTERVAL_MIN     12u    // 15 ms
+#define FAST_INTERVAL_MAX     24u    // 30 ms
+#define FAST_LATENCY          0u
+#define FAST_TIMEOUT          200u   // 2 s
+
+#define CE_LENGTH_MIN         0u
+#define CE_LENGTH_MAX         0xFFFFu
+
+#define ATT_MTU_DEFAULT       23u
+
+// After connecting, stay fast for service discovery and the first writes.
+#define OPEN_BURST_MS         5000u
+
+// ---- PHY and data length ---------------------------------------------------------
+// 251 octets take 2120 us on 1M and 1064 us on 2M; allow the longer one so the
+// maximum length holds on either PHY.
+#define DLE_TX_OCTETS_MAX     251u
+#define DLE_TX_TIME_MAX_US    2120u
+#define DLE_TX_OCTETS_DEFAULT 27u
+
+// ---- TX queue ----------------------------------------------------------------------
+#define TXQ_DEPTH             3u     // pending notifications per connection
+#define TXQ_SLOT_LEN          244u   // ATT_MTU 247 - 3
+#define TXQ_RETRY_MIN_MS      8u
+
+// ---- Notifiable characteristics --------------------------------------------------
+// Index in this table is the subscription bit of a characteristic. coalesce:
+// a newer value replaces a queued one instead of queuing behind it. The bits
+// are persisted for bonded clients (bond.c): only append to this table.
+typedef struct {
+  uint16_t characteristic;
+  bool     coalesce;
+} notify_char_t;
+
+static const notify_char_t s_notify_chars[] = {
+  { gattdb_flow_rate,        true  },
+  { gattdb_send_error,       true  },
+  { gattdb_telemetry,        true  },
+  { gattdb_telemetry_stream, false },   // every batch carries new records
+  { gattdb_link_params,      true  },
+  { gattdb_command,          false },   // replies and history frames
+};
+#define NOTIFY_CHAR_COUNT  (sizeof(s_notify_chars) / sizeof(s_notify_chars[0]))
+
+// ---- Internal State --------------------------------------------------------------
+typedef struct {
+  uint16_t characteristic;
+  uint8_t  len;
+  uint8_t  data[TXQ_SLOT_LEN];
+} txq_slot_t;
+
+typedef struct {
+  bool          used;
+  uint8_t       connection;
+  uint8_t       requested;     // link_profile_t last accepted by the stack
+  link_params_t params;        // as reported by the stack
+  uint32_t      subs;          // subscription bits (s_notify_chars index)
+  uint16_t      mtu;           // negotiated ATT_MTU
+  bool          bulk;          // throughput measurement running
+  uint32_t      bulk_start_ms;
+  uint32_t      bulk_bytes;
+  uint8_t       bonding;       // bonding handle, LINK_NO_BONDING if none
+  uint32_t      opened_ms;
+  bool          notified;      // first notification already timed
+  txq_slot_t    txq[TXQ_DEPTH];  // ring of refused notifications
+  uint8_t       txq_head;
+  uint8_t       txq_count;
+} link_entry_t;
+
+static link_entry_t s_links[SL_BT_CONFIG_MAX_CONNECTIONS];
+static volatile uint32_t s_demand = 0;
+static uint32_t s_burst_until_ms = 0;
+static sl_sleeptimer_timer_handle_t s_burst_tmr;
+static uint32_t s_subs_any = 0;   // OR of all connections' subscription bits
+static sl_sleeptimer_timer_handle_t s_txq_tmr;
+static link_txq_stats_t s_txq_stats;
+static link_first_notify_stats_t s_first_notify[2];   // [0] fresh, [1] bonded
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static link_entry_t *find(uint8_t connection)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_links[i].used && s_links[i].connection == connection) return &s_links[i];
+  }
+  return NULL;
+}
+
+static uint32_t sub_bit(uint16_t characteristic)
+{
+  for (uint32_t i = 0; i < NOTIFY_CHAR_COUNT; i++) {
+    if (s_notify_chars[i].characteristic == characteristic) return 1u << i;
+  }
+  return 0;
+}
+
+static void subs_refresh(void)
+{
+  uint32_t any = 0;
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_links[i].used) any |= s_links[i].subs;
+  }
+  s_subs_any = any;
+}
+
+static bool coalesces(uint16_t characteristic)
+{
+  for (uint32_t i = 0; i < NOTIFY_CHAR_COUNT; i++) {
+    if (s_notify_chars[i].characteristic == characteristic) return s_notify_chars[i].coalesce;
+  }
+  return false;
+}
+
+static void txq_depth_refresh(void)
+{
+  uint16_t depth = 0;
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_links[i].used) depth += s_links[i].txq_count;
+  }
+  s_txq_stats.depth = depth;
+  if (depth > s_txq_stats.depth_max) s_txq_stats.depth_max = depth;
+}
+
+static void txq_retry_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+  (void)sl_bt_external_signal(SIG_TXQ);
+}
+
+// Retry after the shortest connection interval among links with pending data.
+static void txq_arm_retry(void)
+{
+  uint32_t ms = 0xFFFFFFFFu;
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    link_entry_t *e = &s_links[i];
+    if (!e->used || e->txq_count == 0) continue;
+    uint32_t iv = (uint32_t)e->params.interval * 5u / 4u;
+    if (iv < ms) ms = iv;
+  }
+  if (ms == 0xFFFFFFFFu) return;
+  if (ms < TXQ_RETRY_MIN_MS) ms = TXQ_RETRY_MIN_MS;
+
+  bool running = false;
+  (void)sl_sleeptimer_is_timer_running(&s_txq_tmr, &running);
+  if (!running) {
+    (void)sl_sleeptimer_start_timer_ms(&s_txq_tmr, ms, txq_retry_cb, NULL, 0, 0);
+  }
+}
+
+// Queue a refused notification. Coalescing characteristics overwrite their
+// pending value; a full queue drops its oldest entry.
+static void txq_push(link_entry_t *e, uint16_t characteristic,
+                     size_t len, const uint8_t *data)
+{
+  if (len > TXQ_SLOT_LEN) {
+    s_txq_stats.dropped++;
+    return;
+  }
+
+  txq_slot_t *slot = NULL;
+  if (coalesces(characteristic)) {
+    for (uint8_t i = 0; i < e->txq_count; i++) {
+      txq_slot_t *q = &e->txq[(e->txq_head + i) % TXQ_DEPTH];
+      if (q->characteristic == characteristic) {
+        slot = q;
+        s_txq_stats.coalesced++;
+        break;
+      }
+    }
+  }
+  if (slot == NULL) {
+    if (e->txq_count == TXQ_DEPTH) {
+      e->txq_head = (uint8_t)((e->txq_head + 1u) % TXQ_DEPTH);
+      e->txq_count--;
+      s_txq_stats.dropped++;
+    }
+    slot = &e->txq[(e->txq_head + e->txq_count) % TXQ_DEPTH];
+    e->txq_count++;
+    s_txq_stats.queued++;
+  }
+
+  slot->characteristic = characteristic;
+  slot->len = (uint8_t)len;
+  for (size_t i = 0; i < len; i++) slot->data[i] = data[i];
+}
+
+static uint32_t now_ms(void)
+{
+  return sl_sleeptimer_tick_to_ms(sl_sleeptimer_get_tick_count());
+}
+
+static void count_sent(link_entry_t *e, size_t len)
+{
+  if (e->bulk) e->bulk_bytes += (uint32_t)len;
+  if (!e->notified) {
+    e->notified = true;
+    link_first_notify_stats_t *st = &s_first_notify[e->bonding != LINK_NO_BONDING];
+    st->last_ms = now_ms() - e->opened_ms;
+    st->count++;
+    st->sum_ms += st->last_ms;
+    LOG_INFO(BLE, "Link %u: first notification %lu ms after open (%s, avg %lu ms)\r\n",
+                  (unsigned)e->connection, (unsigned long)st->last_ms,
+                  (e->bonding != LINK_NO_BONDING) ? "bonded" : "fresh",
+                  (unsigned long)(st->sum_ms / st->count));
+  }
+}
+
+// Send what the stack accepts, oldest first; stop at the first refusal.
+static void txq_drain(link_entry_t *e)
+{
+  while (e->txq_count != 0) {
+    txq_slot_t *q = &e->txq[e->txq_head];
+    sl_status_t sc = SL_STATUS_OK;
+    // A client may have unsubscribed while the value waited.
+    if (e->subs & sub_bit(q->characteristic)) {
+      sc = sl_bt_gatt_server_send_notification(e->connection, q->characteristic,
+                                               q->len, q->data);
+    }
+    if (sc == SL_STATUS_NO_MORE_RESOURCE) break;
+    if (sc == SL_STATUS_OK) {
+      s_txq_stats.retried++;
+      count_sent(e, q->len);
+    } else {
+      s_txq_stats.dropped++;
+    }
+    e->txq_head = (uint8_t)((e->txq_head + 1u) % TXQ_DEPTH);
+    e->txq_count--;
+  }
+}
+
+static void burst_end_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_demand &= ~LINK_DEMAND_BURST;
+  CORE_EXIT_CRITICAL();
+  (void)sl_bt_external_signal(SIG_LINK);
+}
+
+static sl_status_t request_profile(uint8_t connection, link_profile_t profile)
+{
+  if (profile == LINK_PROFILE_FAST) {
+    return sl_bt_connection_set_parameters(connection,
+                                           FAST_INTERVAL_MIN, FAST_INTERVAL_MAX,
+                                           FAST_LATENCY, FAST_TIMEOUT,
+                                           CE_LENGTH_MIN, CE_LENGTH_MAX);
+  }
+  return sl_bt_connection_set_parameters(connection,
+                                         IDLE_INTERVAL_MIN, IDLE_INTERVAL_MAX,
+                                         IDLE_LATENCY, IDLE_TIMEOUT,
+                                         CE_LENGTH_MIN, CE_LENGTH_MAX);
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void link_opened(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  for (uint32_t i = 0; e == NULL && i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (!s_links[i].used) e = &s_links[i];
+  }
+  if (e == NULL) return;
+
+  *e = (link_entry_t){ .used = true, .connection = connection,
+                       .requested = LINK_PROFILE_NONE, .mtu = ATT_MTU_DEFAULT,
+                       .bonding = LINK_NO_BONDING, .opened_ms = now_ms() };
+  e->params.phy = sl_bt_gap_phy_1m;
+  e->params.tx_octets = DLE_TX_OCTETS_DEFAULT;
+  // Keep the central's (usually fast) parameters during discovery.
+  link_burst(OPEN_BURST_MS);
+
+  // 2M preferred, 1M still accepted: the central may decline the update.
+  sl_status_t sc = sl_bt_connection_set_preferred_phy(connection, sl_bt_gap_phy_2m,
+                                                      sl_bt_gap_phy_1m | sl_bt_gap_phy_2m);
+  if (sc != SL_STATUS_OK) {
+    LOG_WARN(BLE, "Link %u: PHY request failed sc=0x%04lx, staying on 1M\r\n",
+                  (unsigned)connection, (unsigned long)sc);
+  }
+  sc = sl_bt_connection_set_data_length(connection, DLE_TX_OCTETS_MAX, DLE_TX_TIME_MAX_US);
+  if (sc != SL_STATUS_OK) {
+    LOG_WARN(BLE, "Link %u: data length request failed sc=0x%04lx\r\n",
+                  (unsigned)connection, (unsigned long)sc);
+  }
+}
+
+void link_closed(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return;
+  e->used = false;
+  e->subs = 0;
+  s_txq_stats.dropped += e->txq_count;
+  e->txq_count = 0;
+  subs_refresh();
+  txq_depth_refresh();
+}
+
+void link_params_updated(uint8_t connection, uint16_t interval,
+                         uint16_t latency, uint16_t timeout)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return;
+
+  e->params.interval = interval;
+  e->params.latency  = latency;
+  e->params.timeout  = timeout;
+  e->params.profile  = e->requested;
+  LOG_INFO(BLE, "Link %u: interval %u.%02u ms, latency %u, timeout %u ms\r\n",
+                (unsigned)connection,
+                (unsigned)(interval * 125u / 100u), (unsigned)(interval * 125u % 100u),
+                (unsigned)latency, (unsigned)timeout * 10u);
+}
+
+void link_phy_updated(uint8_t connection, uint8_t phy)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return;
+
+  e->params.phy = phy;
+  if (phy == sl_bt_gap_phy_2m) {
+    LOG_DEBUG(BLE, "Link %u: 2M PHY\r\n", (unsigned)connection);
+  } else {
+    LOG_INFO(BLE, "Link %u: central kept PHY %u, bulk transfers run slower\r\n",
+                  (unsigned)connection, (unsigned)phy);
+  }
+}
+
+void link_data_length_updated(uint8_t connection, uint16_t tx_octets)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return;
+
+  e->params.tx_octets = tx_octets;
+  LOG_DEBUG(BLE, "Link %u: LL data length %u\r\n", (unsigned)connection, (unsigned)tx_octets);
+}
+
+bool link_get_params(uint8_t connection, link_params_t *out)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return false;
+  *out = e->params;
+  return true;
+}
+
+void link_mtu_updated(uint8_t connection, uint16_t mtu)
+{
+  link_entry_t *e = find(connection);
+  if (e != NULL) e->mtu = mtu;
+}
+
+uint16_t link_min_mtu(uint16_t characteristic)
+{
+  uint32_t bit = sub_bit(characteristic);
+  uint16_t mtu = 0xFFFFu;
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_links[i].used && (s_links[i].subs & bit) && s_links[i].mtu < mtu) {
+      mtu = s_links[i].mtu;
+    }
+  }
+  return (mtu == 0xFFFFu) ? ATT_MTU_DEFAULT : mtu;
+}
+
+size_t link_pack_params(const link_params_t *p, uint8_t *buf)
+{
+  buf[0] = (uint8_t)p->interval;
+  buf[1] = (uint8_t)(p->interval >> 8);
+  buf[2] = (uint8_t)p->latency;
+  buf[3] = (uint8_t)(p->latency >> 8);
+  buf[4] = (uint8_t)p->timeout;
+  buf[5] = (uint8_t)(p->timeout >> 8);
+  buf[6] = p->profile;
+  buf[7] = p->phy;
+  buf[8] = (uint8_t)p->tx_octets;
+  buf[9] = (uint8_t)(p->tx_octets >> 8);
+  buf[10] = (uint8_t)p->throughput_bps;
+  buf[11] = (uint8_t)(p->throughput_bps >> 8);
+  buf[12] = (uint8_t)(p->throughput_bps >> 16);
+  buf[13] = (uint8_t)(p->throughput_bps >> 24);
+  return LINK_PARAMS_PACKED_LEN;
+}
+
+void link_set_demand(uint32_t demand, bool on)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (on) s_demand |= demand;
+  else    s_demand &= ~demand;
+  CORE_EXIT_CRITICAL();
+  (void)sl_bt_external_signal(SIG_LINK);
+}
+
+void link_burst(uint32_t ms)
+{
+  uint32_t until = now_ms() + ms;
+  bool running = false;
+  (void)sl_sleeptimer_is_timer_running(&s_burst_tmr, &running);
+  // Only ever extend a running burst.
+  if (running && (int32_t)(until - s_burst_until_ms) <= 0) return;
+
+  s_burst_until_ms = until;
+  (void)sl_sleeptimer_stop_timer(&s_burst_tmr);
+  (void)sl_sleeptimer_start_timer_ms(&s_burst_tmr, ms, burst_end_cb, NULL, 0, 0);
+  link_set_demand(LINK_DEMAND_BURST, true);
+}
+
+void link_process(void)
+{
+  link_profile_t want = (s_demand != 0) ? LINK_PROFILE_FAST : LINK_PROFILE_IDLE;
+
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    link_entry_t *e = &s_links[i];
+    if (!e->used || e->requested == want) continue;
+
+    // The initial burst keeps whatever the central chose; no request needed.
+    if (e->requested == LINK_PROFILE_NONE && s_demand == LINK_DEMAND_BURST) continue;
+
+    sl_status_t sc = request_profile(e->connection, want);
+    if (sc == SL_STATUS_OK) {
+      e->requested = (uint8_t)want;
+    } else {
+      LOG_WARN(BLE, "Link %u: parameter request failed sc=0x%04lx\r\n",
+                    (unsigned)e->connection, (unsigned long)sc);
+    }
+  }
+}
+
+void link_bulk_begin(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return;
+  e->bulk = true;
+  e->bulk_bytes = 0;
+  e->bulk_start_ms = now_ms();
+}
+
+uint32_t link_bulk_end(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL || !e->bulk) return 0;
+  e->bulk = false;
+
+  // Up to the last notification handed to the stack, not its delivery on air.
+  uint32_t ms = now_ms() - e->bulk_start_ms;
+  if (ms == 0) ms = 1;
+  e->params.throughput_bps = (uint32_t)(((uint64_t)e->bulk_bytes * 1000u) / ms);
+  LOG_INFO(BLE, "Link %u: bulk %lu bytes in %lu ms = %lu B/s (PHY %u, %u octets)\r\n",
+                (unsigned)connection, (unsigned long)e->bulk_bytes, (unsigned long)ms,
+                (unsigned long)e->params.throughput_bps, (unsigned)e->params.phy,
+                (unsigned)e->params.tx_octets);
+  return e->params.throughput_bps;
+}
+
+void link_set_subscribed(uint8_t connection, uint16_t characteristic, bool on)
+{
+  link_entry_t *e = find(connection);
+  uint32_t bit = sub_bit(characteristic);
+  if (e == NULL || bit == 0) return;
+
+  if (on) e->subs |= bit;
+  else    e->subs &= ~bit;
+  subs_refresh();
+}
+
+uint32_t link_get_subscriptions(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  return (e != NULL) ? e->subs : 0;
+}
+
+void link_restore_subscriptions(uint8_t connection, uint32_t subs)
+{
+  link_entry_t *e = find(connection);
+  if (e == NULL) return;
+  e->subs = subs & ((1u << NOTIFY_CHAR_COUNT) - 1u);
+  subs_refresh();
+}
+
+void link_set_bonding(uint8_t connection, uint8_t bonding)
+{
+  link_entry_t *e = find(connection);
+  if (e != NULL) e->bonding = bonding;
+}
+
+uint8_t link_get_bonding(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  return (e != NULL) ? e->bonding : LINK_NO_BONDING;
+}
+
+void link_get_first_notify_stats(bool bonded, link_first_notify_stats_t *out)
+{
+  *out = s_first_notify[bonded];
+}
+
+bool link_is_subscribed(uint8_t connection, uint16_t characteristic)
+{
+  link_entry_t *e = find(connection);
+  return (e != NULL) && (e->subs & sub_bit(characteristic)) != 0;
+}
+
+bool link_any_subscribed(uint16_t characteristic)
+{
+  return (s_subs_any & sub_bit(characteristic)) != 0;
+}
+
+bool link_any_subscriber(void)
+{
+  return s_subs_any != 0;
+}
+
+sl_status_t link_notify(uint8_t connection, uint16_t characteristic,
+                        size_t len, const uint8_t *data)
+{
+  uint32_t bit = sub_bit(characteristic);
+  if ((s_subs_any & bit) == 0) return SL_STATUS_OK;
+
+  sl_status_t result = SL_STATUS_OK;
+  bool pending = false;
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    link_entry_t *e = &s_links[i];
+    if (!e->used || (e->subs & bit) == 0) continue;
+    if (connection != LINK_ALL && e->connection != connection) continue;
+
+    // Anything already waiting goes first, so values keep their order.
+    if (e->txq_count != 0) txq_drain(e);
+
+    sl_status_t sc = SL_STATUS_NO_MORE_RESOURCE;
+    if (e->txq_count == 0) {
+      sc = sl_bt_gatt_server_send_notification(e->connection, characteristic,
+                                               len, data);
+    }
+    TRACE(TRACE_EV_NOTIFY, (sc & 0xFFu) | ((uint32_t)e->connection << 8)
+                           | ((uint32_t)characteristic << 16));
+    if (sc == SL_STATUS_NO_MORE_RESOURCE) {
+      txq_push(e, characteristic, len, data);
+      pending = true;
+    } else if (sc == SL_STATUS_OK) {
+      count_sent(e, len);
+    } else if (sc != SL_STATUS_OK) {
+      result = sc;
+    }
+  }
+  if (pending) {
+    txq_depth_refresh();
+    txq_arm_retry();
+  }
+  return result;
+}
+
+void link_txq_process(void)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_links[i].used && s_links[i].txq_count != 0) txq_drain(&s_links[i]);
+  }
+  txq_depth_refresh();
+  txq_arm_retry();
+}
+
+bool link_txq_busy(uint8_t connection)
+{
+  link_entry_t *e = find(connection);
+  return (e != NULL) && e->txq_count != 0;
+}
+
+void link_get_txq_stats(link_txq_stats_t *out)
+{
+  *out = s_txq_stats;
+}
+
+size_t link_pack_txq_stats(const link_txq_stats_t *st, uint8_t *buf)
+{
+  const uint32_t v[] = { st->queued, st->coalesced, st->dropped, st->retried };
+  buf[0] = (uint8_t)st->depth;
+  buf[1] = (uint8_t)(st->depth >> 8);
+  buf[2] = (uint8_t)st->depth_max;
+  buf[3] = (uint8_t)(st->depth_max >> 8);
+  for (uint32_t i = 0; i < 4; i++) {
+    buf[4 + 4 * i] = (uint8_t)v[i];
+    buf[5 + 4 * i] = (uint8_t)(v[i] >> 8);
+    buf[6 + 4 * i] = (uint8_t)(v[i] >> 16);
+    buf[7 + 4 * i] = (uint8_t)(v[i] >> 24);
+  }
+  return LINK_TXQ_STATS_PACKED_LEN;
+}
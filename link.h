@@ -0,0 +1,124 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sl_status.h"
+
+// BLE kapcsolatok nyilvántartása és a connection paraméter policy
+// (tétlen: hosszú interval + peripheral latency; aktív: rövid interval).
+
+// Igények, amelyek rövid connection intervalt kérnek (bitmaszk, VAGY kapcsolat)
+#define LINK_DEMAND_STREAM   (1u << 0)   // 10 Hz telemetria stream
+#define LINK_DEMAND_BULK     (1u << 1)   // history letöltés
+#define LINK_DEMAND_BURST    (1u << 2)   // időzített: hiba, ill. kapcsolódás utáni discovery
+
+// Kért paraméter profil
+typedef enum {
+  LINK_PROFILE_NONE = 0,   // még nem kértünk semmit (a central beállítása él)
+  LINK_PROFILE_IDLE = 1,
+  LINK_PROFILE_FAST = 2,
+} link_profile_t;
+
+// Egy kapcsolat elért paraméterei (a Link Parameters karakterisztika tartalma),
+// little endian: interval (u16, 1.25 ms), latency (u16), timeout (u16, 10 ms),
+// profile (u8), phy (u8, 1 = 1M, 2 = 2M), tx_octets (u16, LL PDU adat),
+// throughput (u32, utolsó tömeges küldés [bájt/s], 0 = még nem volt)
+typedef struct {
+  uint16_t interval;
+  uint16_t latency;
+  uint16_t timeout;
+  uint8_t  profile;
+  uint8_t  phy;
+  uint16_t tx_octets;
+  uint32_t throughput_bps;
+} link_params_t;
+#define LINK_PARAMS_PACKED_LEN  14u
+
+// Kapcsolat életciklus (BLE task kontextus, sl_bt_on_event)
+void link_opened(uint8_t connection);
+void link_closed(uint8_t connection);
+// A stack által jelentett (elért) paraméterek
+void link_params_updated(uint8_t connection, uint16_t interval,
+                         uint16_t latency, uint16_t timeout);
+// PHY és data length: megnyitáskor 2M PHY-t és maximális LL adathosszt kérünk;
+// ha a central elutasítja, a kapcsolat 1M / 27 bájton marad.
+void link_phy_updated(uint8_t connection, uint8_t phy);
+void link_data_length_updated(uint8_t connection, uint16_t tx_octets);
+bool link_get_params(uint8_t connection, link_params_t *out);
+// Egyeztetett ATT_MTU; link_min_mtu() a feliratkozók legkisebb MTU-ja (23, ha nincs)
+void link_mtu_updated(uint8_t connection, uint16_t mtu);
+uint16_t link_min_mtu(uint16_t characteristic);
+size_t link_pack_params(const link_params_t *p, uint8_t *buf);
+
+// Igény be/ki kapcsolása; a policy a következő link_process() híváskor fut.
+void link_set_demand(uint32_t demand, bool on);
+// LINK_DEMAND_BURST bekapcsolása ms időre (meghosszabbítja a futót)
+void link_burst(uint32_t ms);
+
+// Policy alkalmazása minden kapcsolatra (BLE task, SIG_LINK jelre)
+void link_process(void);
+
+// Tömeges küldés átviteli sebesség mérése: a kezdettől a stack által elfogadott
+// értesítés hasznos bájtok, a link_bulk_end() hívásig eltelt időre vetítve. A
+// stack TX buffereibe kerülés üteme, nem a levegőn átvitt: a mérés végén a
+// buffer(ek)ben még küldésre váró bájtok is benne vannak (rövid átvitelnél
+// felfelé torzít). A vége visszaadja a sebességet [bájt/s], és a Link
+// Parameters throughput mezőjébe is beírja.
+void     link_bulk_begin(uint8_t connection);
+uint32_t link_bulk_end(uint8_t connection);
+
+// ---- Feliratkozások ----------------------------------------------------------------
+// Kapcsolatonként és karakterisztikánként (CCCD notification bit). A
+// connection_closed törli az adott kapcsolat összes feliratkozását.
+#define LINK_ALL  0xFFu   // link_notify(): minden feliratkozott kapcsolat
+
+void link_set_subscribed(uint8_t connection, uint16_t characteristic, bool on);
+bool link_is_subscribed(uint8_t connection, uint16_t characteristic);
+// Feliratkozási bitek egyben (bond.c menti / állítja vissza kötött kliensnél)
+uint32_t link_get_subscriptions(uint8_t connection);
+void     link_restore_subscriptions(uint8_t connection, uint32_t subs);
+
+// Bonding handle a kapcsolathoz (LINK_NO_BONDING: nincs kötés)
+#define LINK_NO_BONDING  0xFFu
+void    link_set_bonding(uint8_t connection, uint8_t bonding);
+uint8_t link_get_bonding(uint8_t connection);
+
+// Kapcsolat megnyitástól az első elfogadott értesítésig eltelt idő
+typedef struct {
+  uint32_t count;
+  uint32_t last_ms;
+  uint32_t sum_ms;
+} link_first_notify_stats_t;
+void link_get_first_notify_stats(bool bonded, link_first_notify_stats_t *out);
+// Van-e legalább egy feliratkozó (stack hívás nélkül)
+bool link_any_subscribed(uint16_t characteristic);
+// Van-e bármely karakterisztikára feliratkozó kapcsolat
+bool link_any_subscriber(void);
+
+// Értesítés a feliratkozott kapcsolat(ok)nak. Ha senki nincs feliratkozva,
+// egyetlen stack hívás sem történik (SL_STATUS_OK). Amit a stack buffer hiány
+// miatt visszautasít, az a kapcsolat TX sorába kerül (nem hiba).
+sl_status_t link_notify(uint8_t connection, uint16_t characteristic,
+                        size_t len, const uint8_t *data);
+
+// ---- TX sor ------------------------------------------------------------------------
+// Visszautasított értesítések kapcsolatonként; újrapróbálás kb. egy connection
+// interval múlva (SIG_TXQ jel -> link_txq_process()).
+typedef struct {
+  uint16_t depth;       // jelenleg sorban álló értesítések (összes kapcsolat)
+  uint16_t depth_max;   // legnagyobb mért mélység
+  uint32_t queued;      // sorba került értesítések
+  uint32_t coalesced;   // sorban álló értéket felülíró újabb értékek
+  uint32_t dropped;     // eldobott értesítések (tele sor, lezárt kapcsolat, hiba)
+  uint32_t retried;     // újrapróbálással elküldött értesítések
+} link_txq_stats_t;
+
+// Csomagolt forma (TX Queue Stats karakterisztika), little endian:
+// depth (u16), depth_max (u16), queued, coalesced, dropped, retried (u32)
+#define LINK_TXQ_STATS_PACKED_LEN  20u
+
+void link_txq_process(void);
+// Van-e sorban álló értesítés a kapcsolaton (tömeges küldés ilyenkor vár)
+bool link_txq_busy(uint8_t connection);
+void link_get_txq_stats(link_txq_stats_t *out);
+size_t link_pack_txq_stats(const link_txq_stats_t *st, uint8_t *buf);
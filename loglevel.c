@@ -0,0 +1,53 @@
+// -----------------------------------------------------------------------------
+// loglevel.c — Runtime part of the per-module log levels
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Hold the runtime threshold of every module (loglevel.h), checked by the
+//     LOG_*() macros after the compile-time test has let the call in.
+//   • Apply overrides from the Command characteristic, clamped to what was
+//     compiled in: a stripped level cannot be brought back at runtime.
+//
+// Concurrency model & safety notes:
+//   • Thresholds are single bytes, written from the BLE task and read from any
+//     context; a reader sees either the old or the new level.
+//   • Overrides live in RAM only and reset to LOG_BOOT_LEVEL on reboot.
+//
+// -----------------------------------------------------------------------------
+
+#include "loglevel.h"
+
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+
+static const uint8_t s_build[LOG_MOD_COUNT] = {
+  [LOG_MOD_CONTROL] = LOG_BUILD_CONTROL,
+  [LOG_MOD_BLE]     = LOG_BUILD_BLE,
+  [LOG_MOD_POWER]   = LOG_BUILD_POWER,
+  [LOG_MOD_STORAGE] = LOG_BUILD_STORAGE,
+};
+
+uint8_t g_log_level[LOG_MOD_COUNT] = {
+  [LOG_MOD_CONTROL] = MAX(LOG_BOOT_LEVEL, LOG_BUILD_CONTROL),
+  [LOG_MOD_BLE]     = MAX(LOG_BOOT_LEVEL, LOG_BUILD_BLE),
+  [LOG_MOD_POWER]   = MAX(LOG_BOOT_LEVEL, LOG_BUILD_POWER),
+  [LOG_MOD_STORAGE] = MAX(LOG_BOOT_LEVEL, LOG_BUILD_STORAGE),
+};
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+bool loglevel_set(uint8_t module, uint8_t level)
+{
+  if (module >= LOG_MOD_COUNT || level > LOG_LEVEL_OFF) return false;
+  g_log_level[module] = MAX(level, s_build[module]);
+  return true;
+}
+
+uint8_t loglevel_get(uint8_t module)
+{
+  return (module < LOG_MOD_COUNT) ? g_log_level[module] : LOG_LEVEL_OFF;
+}
+
+uint8_t loglevel_build(uint8_t module)
+{
+  return (module < LOG_MOD_COUNT) ? s_build[module] : LOG_LEVEL_OFF;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_log.h"
+
+// Modulonkénti log szintek. Két küszöb van:
+//   • LOG_BUILD_<MOD>: fordítási idejű; ez alatti szintű hívásból sem kód,
+//     sem string nem kerül a flashbe (konstans hamis feltétel, -O0-n is).
+//   • futásidejű szint: boot után LOG_BOOT_LEVEL, GATT-on (CMD_TLV_LOG_LEVEL)
+//     modulonként állítható a LOG_BUILD_<MOD> szintig; RAM-ban él, resetkor
+//     visszaáll. Terepen így egy modul ideiglenesen bőbeszédűbb lehet.
+// A fordítási szint projekt szinten felülírható (pl. -DLOG_BUILD_LEVEL=0).
+// A flash megtakarítás szintenként: tools/log_flash_report.py (map fájlok).
+
+#define LOG_MOD_CONTROL   0u   // pumpa, mérés, analóg
+#define LOG_MOD_BLE       1u   // kapcsolat, GATT, hirdetés, kötés
+#define LOG_MOD_POWER     2u   // TX teljesítmény, energia módok
+#define LOG_MOD_STORAGE   3u   // NVM3 (kulcsok, mentett beállítások)
+#define LOG_MOD_COUNT     4u
+
+#define LOG_LEVEL_OFF     (APP_LOG_LEVEL_CRITICAL + 1)
+
+#ifndef LOG_BUILD_LEVEL
+#define LOG_BUILD_LEVEL   APP_LOG_LEVEL_INFO
+#endif
+#ifndef LOG_BUILD_CONTROL
+#define LOG_BUILD_CONTROL LOG_BUILD_LEVEL
+#endif
+#ifndef LOG_BUILD_BLE
+#define LOG_BUILD_BLE     LOG_BUILD_LEVEL
+#endif
+#ifndef LOG_BUILD_POWER
+#define LOG_BUILD_POWER   LOG_BUILD_LEVEL
+#endif
+#ifndef LOG_BUILD_STORAGE
+#define LOG_BUILD_STORAGE LOG_BUILD_LEVEL
+#endif
+
+// Futásidejű szint boot után (nem lehet a fordítási szint alatt)
+#ifndef LOG_BOOT_LEVEL
+#define LOG_BOOT_LEVEL    APP_LOG_LEVEL_WARNING
+#endif
+
+extern uint8_t g_log_level[LOG_MOD_COUNT];
+
+// true, ha a szint befordul és most engedélyezett (blokkokhoz, pl. hexdump)
+#define LOG_ON(mod, lvl) \
+  ((lvl) >= LOG_BUILD_##mod && (lvl) >= g_log_level[LOG_MOD_##mod])
+
+#define LOG_DEBUG(mod, ...)  LOG_AT_(mod, APP_LOG_LEVEL_DEBUG, app_log_debug, __VA_ARGS__)
+#define LOG_INFO(mod, ...)   LOG_AT_(mod, APP_LOG_LEVEL_INFO, app_log_info, __VA_ARGS__)
+#define LOG_WARN(mod, ...)   LOG_AT_(mod, APP_LOG_LEVEL_WARNING, app_log_warning, __VA_ARGS__)
+#define LOG_ERROR(mod, ...)  LOG_AT_(mod, APP_LOG_LEVEL_ERROR, app_log_error, __VA_ARGS__)
+
+#define LOG_AT_(mod, lvl, fn, ...) \
+  do { if (LOG_ON(mod, lvl)) fn(__VA_ARGS__); } while (0)
+
+// Futásidejű szint (0 = debug .. LOG_LEVEL_OFF); a fordítási szintre vágva.
+// false, ha a modul vagy a szint érvénytelen.
+bool    loglevel_set(uint8_t module, uint8_t level);
+uint8_t loglevel_get(uint8_t module);
+// A modul fordítási szintje (ennél bőbeszédűbb nem állítható)
+uint8_t loglevel_build(uint8_t module);
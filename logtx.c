@@ -0,0 +1,202 @@
+// -----------------------------------------------------------------------------
+// logtx.c — Asynchronous, LDMA-driven log output on the VCOM USART
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Replace the blocking VCOM write path (about 87 us per byte at 115200
+//     baud) with a RAM ring. The default iostream is pointed at a stream
+//     whose write only copies into the ring, so app_log(), printf() and the
+//     tlog drain all become non-blocking. Reads still go to the VCOM stream.
+//   • Drain the ring into USART1 TXDATA with one LDMA transfer per contiguous
+//     chunk; the completion callback starts the next chunk.
+//   • Drop a write that does not fit as a whole (a tlog record is never cut)
+//     and count it; nothing ever waits for the USART. logtx_try_write() is
+//     for writers that keep the data and retry (tlog): a refusal is reported
+//     as SL_STATUS_WOULD_BLOCK and not counted as a drop.
+//   • Hold an EM1 requirement only while a transfer runs, so the CPU sleeps
+//     during the transfer and EM2 is allowed once the last byte has left.
+//
+// Concurrency model & safety notes:
+//   • Producers (task, sleeptimer, IRQ) reserve and copy inside a short
+//     critical section; there is no waiting in it. The single consumer is the
+//     LDMA completion callback (IRQ), the only place that moves the tail.
+//   • The chunk being transferred lies between tail and the head seen when
+//     it started; producers only write beyond the head, never into it.
+//   • LDMA completion means the last byte entered the USART, not that it was
+//     shifted out, so EM1 is released LOGTX_DRAIN_MS later by a sleeptimer.
+//
+// Hardware assumptions:
+//   • USART1 is the VCOM set up by sl_iostream_usart (pins, baud rate, CTS/RTS
+//     flow control); this module only feeds TXDATA through LDMA.
+//
+// -----------------------------------------------------------------------------
+
+#include "logtx.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "em_usart.h"
+#include "dmadrv.h"
+#include "sl_iostream.h"
+#include "sl_iostream_handles.h"
+#include "sl_power_manager.h"
+#include "sl_sleeptimer.h"
+
+#define LOGTX_MASK       (LOGTX_RING_SIZE - 1u)
+#define LOGTX_DRAIN_MS   1u      // > 2 characters at 115200 baud
+
+// ---- Internal State --------------------------------------------------------------
+static uint8_t           s_ring[LOGTX_RING_SIZE];
+static volatile uint32_t s_head = 0;          // free running, producers
+static volatile uint32_t s_tail = 0;          // free running, LDMA callback
+static volatile uint32_t s_inflight = 0;      // length of the running transfer
+static volatile bool     s_em1 = false;       // EM1 requirement held
+static unsigned int      s_dma_ch;
+static LDMA_Descriptor_t s_desc;
+static bool              s_ready = false;
+static sl_sleeptimer_timer_handle_t s_drain_tmr;
+static logtx_stats_t     s_stats;
+
+static sl_status_t stream_write(void *context, const void *buffer, size_t len);
+static sl_status_t stream_read(void *context, void *buffer, size_t len, size_t *bytes_read);
+
+static sl_iostream_t s_stream = {
+  .context = NULL,
+  .write   = stream_write,
+  .read    = stream_read,
+};
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static void drain_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  // A new transfer may have started meanwhile; it keeps the requirement.
+  if (s_inflight == 0 && s_em1) {
+    s_em1 = false;
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+static bool dma_done_cb(unsigned int channel, unsigned int sequenceNo, void *userParam);
+
+// Start the next contiguous chunk; call with interrupts disabled.
+static void kick(void)
+{
+  if (s_inflight != 0 || s_tail == s_head) return;
+
+  uint32_t start = s_tail & LOGTX_MASK;
+  uint32_t len = s_head - s_tail;
+  if (len > LOGTX_RING_SIZE - start) len = LOGTX_RING_SIZE - start;
+
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART1_TXBL);
+  s_desc = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&s_ring[start],
+                                                              &USART1->TXDATA, len);
+  if (!s_em1) {
+    s_em1 = true;
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+  s_inflight = len;
+  if (DMADRV_LdmaStartTransfer((int)s_dma_ch, &cfg, &s_desc, dma_done_cb, NULL)
+      != ECODE_EMDRV_DMADRV_OK) {
+    // Nothing else to report the error to; the data is discarded.
+    s_tail += len;
+    s_stats.dropped += len;
+    s_inflight = 0;
+    (void)sl_sleeptimer_restart_timer_ms(&s_drain_tmr, LOGTX_DRAIN_MS, drain_cb, NULL, 0, 0);
+    return;
+  }
+  s_stats.dma_transfers++;
+}
+
+static bool dma_done_cb(unsigned int channel, unsigned int sequenceNo, void *userParam)
+{
+  (void)channel; (void)sequenceNo; (void)userParam;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_tail += s_inflight;
+  s_inflight = 0;
+  kick();
+  if (s_inflight == 0) {
+    (void)sl_sleeptimer_restart_timer_ms(&s_drain_tmr, LOGTX_DRAIN_MS, drain_cb, NULL, 0, 0);
+  }
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+static sl_status_t stream_write(void *context, const void *buffer, size_t len)
+{
+  (void)context;
+  return logtx_write(buffer, len) ? SL_STATUS_OK : SL_STATUS_FULL;
+}
+
+static sl_status_t stream_read(void *context, void *buffer, size_t len, size_t *bytes_read)
+{
+  (void)context;
+  return sl_iostream_read(sl_iostream_vcom_handle, buffer, len, bytes_read);
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+bool logtx_init(void)
+{
+  DMADRV_Init();
+  if (DMADRV_AllocateChannel(&s_dma_ch, NULL) != ECODE_EMDRV_DMADRV_OK) {
+    return false;
+  }
+  s_ready = true;
+  return sl_iostream_set_default(&s_stream) == SL_STATUS_OK;
+}
+
+sl_status_t logtx_try_write(const void *data, size_t len)
+{
+  if (!s_ready) {
+    return sl_iostream_write(sl_iostream_vcom_handle, data, len);
+  }
+
+  const uint8_t *src = data;
+  bool fits;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  uint32_t used = s_head - s_tail;
+  fits = (len <= LOGTX_RING_SIZE - used);
+  if (fits) {
+    for (size_t i = 0; i < len; i++) {
+      s_ring[(s_head + i) & LOGTX_MASK] = src[i];
+    }
+    s_head += len;
+    s_stats.written += len;
+    if (used + len > s_stats.high_water) s_stats.high_water = (uint16_t)(used + len);
+    kick();
+  }
+  CORE_EXIT_CRITICAL();
+  return fits ? SL_STATUS_OK : SL_STATUS_WOULD_BLOCK;
+}
+
+bool logtx_write(const void *data, size_t len)
+{
+  sl_status_t sc = logtx_try_write(data, len);
+  if (sc == SL_STATUS_WOULD_BLOCK) {
+    CORE_DECLARE_IRQ_STATE;
+    CORE_ENTER_CRITICAL();
+    s_stats.dropped += len;
+    s_stats.dropped_writes++;
+    CORE_EXIT_CRITICAL();
+  }
+  return sc == SL_STATUS_OK;
+}
+
+void logtx_get_stats(logtx_stats_t *out)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = s_stats;
+  CORE_EXIT_CRITICAL();
+}
+
+int logtx_dma_channel(void)
+{
+  return s_ready ? (int)s_dma_ch : -1;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sl_status.h"
+
+// Nem blokkoló log kimenet: az írók (app_log / printf, tlog) egy RAM gyűrűbe
+// másolnak, a VCOM USART1 TX-et LDMA üríti a háttérben. Teli gyűrűnél az
+// egész írás eldobódik és számlálódik, a hívó sosem vár. Átvitel alatt csak
+// EM1 igény van (a CPU alszik), utána EM2 engedélyezett.
+
+#define LOGTX_RING_SIZE   1024u   // 2 hatványa, <= 2048 (egy LDMA leíró)
+
+typedef struct {
+  uint32_t written;        // gyűrűbe került bájtok
+  uint32_t dropped;        // eldobott bájtok (teli gyűrű, logtx_write)
+  uint32_t dropped_writes; // eldobott írások (logtx_write)
+  uint32_t dma_transfers;
+  uint16_t high_water;     // legnagyobb foglaltság [bájt]
+} logtx_stats_t;
+
+// A VCOM stream (sl_iostream_vcom_handle) inicializálása után: DMA csatorna
+// foglalás, és a log stream lesz az alapértelmezett (printf / app_log).
+// false, ha nincs DMA csatorna; ilyenkor marad a szinkron VCOM.
+bool logtx_init(void);
+
+// Bármely kontextusból; false, ha nem fért el (eldobva, számlálva)
+bool logtx_write(const void *data, size_t len);
+// Mint logtx_write(), de a hívó megtartja és később újra küldi, ami nem fért
+// el: SL_STATUS_WOULD_BLOCK, nem számít eldobásnak (tlog)
+sl_status_t logtx_try_write(const void *data, size_t len);
+
+void logtx_get_stats(logtx_stats_t *out);
+// A log LDMA csatornája (LDMA->IF bit, energy.c); -1, ha nincs (szinkron VCOM)
+int logtx_dma_channel(void);
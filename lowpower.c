@@ -0,0 +1,160 @@
+// -----------------------------------------------------------------------------
+// lowpower.c — Low-power profile while the pump is off and nobody listens
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Decide when the device has nothing to do but wait: the pump is off, its
+//     spin-down is over, no flow was seen since, and no connection is
+//     subscribed to anything.
+//   • In that state release the VCOM USART RX requirement (EM1), so the core
+//     can sleep in EM2, and have control.c stop its thermal sampler and swap
+//     the flow input to its EM4WU wakeup. The TIMER0 PWM gates its own clock
+//     and EM1 requirement when it stops.
+//   • Watch the button through its EM4WU wakeup while in the profile, and
+//     run its press action (open pairing, as sl_button_on_change() does).
+//   • Leave the profile as soon as one of the conditions breaks: pump
+//     enabled, a client subscribes, or a flow edge arrives (control.c).
+//
+// Concurrency model & safety notes:
+//   • Everything runs in BLE task context. Interrupt-side changes (flow edge,
+//     end of spin-down, pump enable, button wake) arrive as SIG_POWER;
+//     subscription changes call lowpower_update() directly from the event
+//     handler. button_wake_cb() only disarms the wakeup and records the level.
+//   • The EM1 requirement taken here is counted by the power manager together
+//     with the other holders (PWM, log DMA), so it is only ever added once and
+//     removed once per profile change.
+//
+// Hardware assumptions:
+//   • SL_IOSTREAM_USART_VCOM_RESTRICT_ENERGY_MODE_TO_ALLOW_RECEPTION is 0: the
+//     VCOM driver no longer holds EM1 itself; this module does, outside the
+//     profile (LOWPOWER_VCOM_RX_NORMAL).
+//   • EFR32xG22 keeps GPIO edge interrupts in EM2 only on port A/B pins. The
+//     flow input (PC00, EM4WU6) and the button (PC07, EM4WU8) are on port C,
+//     so in the profile they wake the core through their EM4WU interrupts,
+//     which work from EM2. These are level sensitive: each is armed for the
+//     level its pin is not at. The radio wakes the core by itself.
+//   • The button is active low; its driver interrupt is disabled while the
+//     EM4WU wakeup watches it (sl_simple_button_disable/enable).
+//
+// -----------------------------------------------------------------------------
+
+#include "lowpower.h"
+#include "control.h"
+#include "link.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "sl_power_manager.h"
+#include "adv.h"
+#include "app.h"
+#include "em_gpio.h"
+#include "em_core.h"
+#include "gpiointerrupt.h"
+#include "sl_simple_button.h"
+#include "sl_simple_button_instances.h"
+#include "sl_simple_button_btn0_config.h"
+
+#define BUTTON_PORT   SL_SIMPLE_BUTTON_BTN0_PORT
+#define BUTTON_PIN    SL_SIMPLE_BUTTON_BTN0_PIN
+#define BUTTON_EM4WU  8u    // PC07 : EM4WU8
+
+// ---- Internal State --------------------------------------------------------------
+static bool     s_active = false;
+static bool     s_rx_em1 = false;   // VCOM RX requirement held
+static uint32_t s_entries = 0;
+static uint32_t s_flow_wakes = 0;
+
+// Button EM4WU wakeup (profile only)
+static bool          s_button_armed = false;
+static volatile bool s_button_woke = false;     // set by button_wake_cb()
+static volatile bool s_button_pressed = false;  // level at that wake
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static void vcom_rx(bool on)
+{
+  if (on == s_rx_em1) return;
+  s_rx_em1 = on;
+  if (on) {
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+  } else {
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+}
+
+// Arm the button's EM4WU wakeup for the level the pin is not at (a press, or
+// the release of a held button), or give the pin back to the button driver.
+static void button_arm(bool on)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (on) {
+    if (!s_button_armed) sl_simple_button_disable(&sl_button_btn0);
+    bool high = GPIO_PinInGet(BUTTON_PORT, BUTTON_PIN) != 0;
+    GPIO_EM4WUExtIntConfig(BUTTON_PORT, BUTTON_PIN, BUTTON_EM4WU, !high, true);
+  } else {
+    GPIO_EM4WUExtIntConfig(BUTTON_PORT, BUTTON_PIN, BUTTON_EM4WU, false, false);
+  }
+  // The config call sets the pull from the polarity; keep the pull-up.
+  GPIO_PinModeSet(BUTTON_PORT, BUTTON_PIN, gpioModeInputPullFilter, 1);
+  if (!on && s_button_armed) sl_simple_button_enable(&sl_button_btn0);
+  s_button_armed = on;
+  CORE_EXIT_CRITICAL();
+}
+
+// ---- IRQ -------------------------------------------------------------------------
+
+// Button EM4WU wake: disarm the level interrupt, the task re-arms it.
+static void button_wake_cb(uint8_t int_no, void *ctx)
+{
+  (void)int_no; (void)ctx;
+  GPIO_EM4WUExtIntConfig(BUTTON_PORT, BUTTON_PIN, BUTTON_EM4WU, false, false);
+  GPIO_PinModeSet(BUTTON_PORT, BUTTON_PIN, gpioModeInputPullFilter, 1);
+  s_button_pressed = GPIO_PinInGet(BUTTON_PORT, BUTTON_PIN) == 0;
+  s_button_woke = true;
+  (void)sl_bt_external_signal(SIG_POWER);
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void lowpower_init(void)
+{
+  vcom_rx(LOWPOWER_VCOM_RX_NORMAL != 0);
+  if (GPIOINT_EM4WUCallbackRegister(BUTTON_PORT, BUTTON_PIN, button_wake_cb, NULL)
+      != BUTTON_EM4WU) {
+    LOG_ERROR(POWER, "Button EM4WU callback not registered\r\n");
+  }
+}
+
+void lowpower_update(void)
+{
+  if (s_button_woke) {
+    s_button_woke = false;
+    // The driver missed this edge: same action as sl_button_on_change().
+    if (s_button_pressed) adv_open_pairing();
+    if (s_active) button_arm(true);
+  }
+
+  bool idle = hydro_is_idle() && !link_any_subscriber();
+  if (idle == s_active) return;
+  s_active = idle;
+
+  if (idle) {
+    s_entries++;
+    hydro_set_low_power(true);
+    button_arm(true);
+    vcom_rx(false);
+    LOG_INFO(POWER, "Low-power profile on (#%lu, %lu left on flow)\r\n",
+                    (unsigned long)s_entries, (unsigned long)s_flow_wakes);
+  } else {
+    if (!hydro_is_enabled() && !link_any_subscriber()) s_flow_wakes++;   // flow edge
+    vcom_rx(LOWPOWER_VCOM_RX_NORMAL != 0);
+    button_arm(false);
+    hydro_set_low_power(false);
+    LOG_INFO(POWER, "Low-power profile off\r\n");
+  }
+}
+
+bool lowpower_is_active(void)
+{
+  return s_active;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Alacsony fogyasztású profil: kikapcsolt pumpánál (lefutás után, átfolyás
+// nélkül) és ha egy kliens sincs feliratkozva. Benne:
+//   • a VCOM USART RX EM1 igénye elengedve (EM2 engedélyezett; a bejövő
+//     soros adat elveszhet),
+//   • a hőmérséklet mintavétel áll, a TIMER0 órajel kikapcsolva (pwm_hw_stop),
+//   • ébresztés: átfolyás él (kilép a profilból), gomb, rádió (kapcsolat);
+//     a PC lábak (átfolyás PC00, gomb PC07) EM4WU ébresztésként figyelnek,
+//     mert a port C él megszakítása EM2-ben nem működik.
+// A feltételeket a BLE task értékeli ki (SIG_POWER jel és feliratkozás változás).
+// Host oldali becslés: tools/energy_model.py.
+
+// 1: a normál profil tartja a VCOM RX-et (EM1), mint a driver korábban
+#define LOWPOWER_VCOM_RX_NORMAL  1
+
+// app_init-ből (a normál profil igényei)
+void lowpower_init(void);
+// BLE task: a profil feltételeinek újraértékelése, szükség esetén váltás
+void lowpower_update(void);
+bool lowpower_is_active(void);
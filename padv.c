@@ -0,0 +1,194 @@
+// -----------------------------------------------------------------------------
+// padv.c — Periodic advertising train with the full telemetry record
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Run a second, non-connectable extended advertising set next to the
+//     connectable legacy set (adv.c). The extended adverts only carry the
+//     SyncInfo pointing at the periodic train plus a short header a gateway
+//     can filter on; the telemetry itself goes into the periodic data.
+//   • Keep the periodic payload in one static buffer with a fixed layout (see
+//     padv.h) and rewrite only the bytes whose value changed since the last
+//     sample. seq and timestamp advance with every sample, so they are left
+//     out of the comparison: a sample whose measured fields are all unchanged
+//     is not handed to the stack at all, and the train keeps the seq and
+//     timestamp of the last sample that changed something.
+//   • The stack API takes the whole payload, so every update still passes all
+//     PADV_DATA_LEN bytes; the rewritten-byte count measures how much of it
+//     actually changed.
+//   • Count updates, skipped samples and rewritten bytes.
+//
+// Concurrency model & safety notes:
+//   • Everything runs in BLE task context (boot event and SIG_SAMPLE).
+//   • The stack copies the data on sl_bt_periodic_advertiser_set_data(), so the
+//     buffer can be modified in place right after the call.
+//
+// -----------------------------------------------------------------------------
+
+#include "padv.h"
+#include "control.h"
+#include "txpwr.h"
+#include "sl_bluetooth.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include <string.h>
+
+#define AD_TYPE_MANUFACTURER   0xFFu
+
+// Periodic interval in 1.25 ms units; the extended adverts that announce the
+// train only need to be found once per sync, so they run slower.
+#define PADV_INTERVAL_UNITS    ((PADV_INTERVAL_MS * 4u) / 5u)
+#define PADV_EXT_INTERVAL      (2000u * 8u / 5u)   // 2 s in 0.625 ms units
+
+#define PADV_TEMP_INVALID      0x7FFF
+#define PADV_STATE_ENABLED     (1u << 0)
+#define PADV_STATE_THERMAL     (1u << 1)
+
+// Field offsets in s_data
+#define OFS_SEQ        5u
+#define OFS_TIMESTAMP  7u
+#define OFS_FLOW       11u
+#define OFS_PULSES     13u
+#define OFS_DUTY       17u
+#define OFS_CURRENT    19u
+#define OFS_TEMP       21u
+#define OFS_FAULTS     23u
+#define OFS_STATE      24u
+
+// Header of the extended advert: the same manufacturer element, no fields
+#define PADV_EXT_DATA_LEN      5u
+
+// Log the update statistics every this many updates
+#define PADV_LOG_EVERY         256u
+
+// ---- Internal State --------------------------------------------------------------
+#if PADV_ENABLE
+static uint8_t      s_handle = 0xFF;
+static uint8_t      s_data[PADV_DATA_LEN];
+#endif
+static bool         s_active = false;
+static padv_stats_t s_stats;
+
+// ---- Helper Functions ------------------------------------------------------------
+#if PADV_ENABLE
+
+static void put_header(uint8_t *p, uint8_t len)
+{
+  p[0] = (uint8_t)(len - 1u);
+  p[1] = AD_TYPE_MANUFACTURER;
+  p[2] = (uint8_t)PADV_COMPANY_ID;
+  p[3] = (uint8_t)(PADV_COMPANY_ID >> 8);
+  p[4] = PADV_FORMAT_VERSION;
+}
+
+// Store a little endian field, touching only the bytes that differ.
+// Returns the number of bytes rewritten.
+static uint8_t put_field(uint8_t ofs, uint32_t v, uint8_t size)
+{
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < size; i++) {
+    uint8_t b = (uint8_t)(v >> (8u * i));
+    if (s_data[ofs + i] != b) {
+      s_data[ofs + i] = b;
+      changed++;
+    }
+  }
+  return changed;
+}
+
+#endif // PADV_ENABLE
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+bool padv_init(void)
+{
+#if PADV_ENABLE
+  uint8_t ext[PADV_EXT_DATA_LEN];
+  sl_status_t sc;
+
+  memset(s_data, 0, sizeof(s_data));
+  put_header(s_data, PADV_DATA_LEN);
+  put_header(ext, PADV_EXT_DATA_LEN);
+  (void)put_field(OFS_TEMP, (uint16_t)PADV_TEMP_INVALID, 2);
+
+  sc = sl_bt_advertiser_create_set(&s_handle);
+  if (sc == SL_STATUS_OK) {
+    sc = txpwr_advertiser_init(s_handle);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_extended_advertiser_set_phy(s_handle, sl_bt_gap_phy_1m, sl_bt_gap_phy_1m);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_advertiser_set_timing(s_handle, PADV_EXT_INTERVAL, PADV_EXT_INTERVAL, 0, 0);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_extended_advertiser_set_data(s_handle, sizeof(ext), ext);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_periodic_advertiser_set_data(s_handle, sizeof(s_data), s_data);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_periodic_advertiser_start(s_handle, PADV_INTERVAL_UNITS, PADV_INTERVAL_UNITS, 0);
+  }
+  if (sc == SL_STATUS_OK) {
+    sc = sl_bt_extended_advertiser_start(s_handle, sl_bt_extended_advertiser_non_connectable, 0);
+  }
+  if (sc != SL_STATUS_OK) {
+    LOG_WARN(BLE, "Periodic advertising not started sc=0x%04lx\r\n", (unsigned long)sc);
+    return false;
+  }
+  s_active = true;
+  LOG_INFO(BLE, "Periodic advertising: %u ms\r\n", (unsigned)PADV_INTERVAL_MS);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool padv_is_active(void) { return s_active; }
+
+sl_status_t padv_update(const telemetry_sample_t *s)
+{
+#if PADV_ENABLE
+  if (!s_active) return SL_STATUS_INVALID_STATE;
+
+  int16_t temp;
+  if (!hydro_get_temp_c_x100(&temp)) temp = PADV_TEMP_INVALID;
+  uint8_t state = (hydro_is_enabled() ? PADV_STATE_ENABLED : 0)
+                  | (hydro_get_thermal_mode() ? PADV_STATE_THERMAL : 0);
+
+  // Measured fields first: seq and timestamp change on every sample.
+  uint32_t n = 0;
+  n += put_field(OFS_FLOW,      s->flow_x100,              2);
+  n += put_field(OFS_PULSES,    s->pulses,                 4);
+  n += put_field(OFS_DUTY,      s->duty_permille,          2);
+  n += put_field(OFS_CURRENT,   hydro_get_current_ma(),    2);
+  n += put_field(OFS_TEMP,      (uint16_t)temp,            2);
+  n += put_field(OFS_FAULTS,    s->faults,                 1);
+  n += put_field(OFS_STATE,     state,                     1);
+
+  if (n == 0) {
+    s_stats.unchanged++;
+    return SL_STATUS_OK;
+  }
+  n += put_field(OFS_SEQ,       s->seq,                    2);
+  n += put_field(OFS_TIMESTAMP, s->timestamp_ms,           4);
+  s_stats.updates++;
+  s_stats.bytes_written += n;
+  if ((s_stats.updates % PADV_LOG_EVERY) == 0) {
+    LOG_DEBUG(BLE, "Periodic adv: %lu updates, %lu unchanged, %lu/%lu bytes rewritten\r\n",
+                   (unsigned long)s_stats.updates, (unsigned long)s_stats.unchanged,
+                   (unsigned long)s_stats.bytes_written,
+                   (unsigned long)(s_stats.updates * PADV_DATA_LEN));
+  }
+  return sl_bt_periodic_advertiser_set_data(s_handle, sizeof(s_data), s_data);
+#else
+  (void)s;
+  return SL_STATUS_INVALID_STATE;
+#endif
+}
+
+void padv_get_stats(padv_stats_t *out)
+{
+  *out = s_stats;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+#include "telemetry.h"
+
+// Periodikus hirdetés (nem kapcsolódó extended set) a teljes telemetriával a
+// connectable legacy set mellett. A gateway szinkronizál a periodikus sorra, és
+// kapcsolat nélkül, fix ütemben kap meg minden mérést.
+// 0: nincs extended/periodic set (csak a legacy BTHome hirdetés).
+#define PADV_ENABLE          1
+
+#define PADV_INTERVAL_MS     1000u     // periodikus intervallum
+#define PADV_COMPANY_ID      0xFFFFu   // manufacturer specific data (teszt ID)
+#define PADV_FORMAT_VERSION  1u
+
+// Periodikus adat (egy manufacturer specific AD elem), little endian:
+//   [0] len  [1] 0xFF  [2..3] company id  [4] formátum verzió
+//   [5..6] seq  [7..10] timestamp_ms  [11..12] flow_x100  [13..16] pulses
+//   [17..18] duty_permille  [19..20] current_ma
+//   [21..22] temp_c_x100 (i16, 0x7FFF = nincs mérés)  [23] faults
+//   [24] állapot: bit0 pumpa be, bit1 termikus mód
+// Csak akkor frissül, ha valamelyik mért mező (flow..állapot) változott; a
+// seq és timestamp az utolsó ilyen mintáé.
+#define PADV_DATA_LEN        25u
+
+// Inkrementális frissítés statisztikája
+typedef struct {
+  uint32_t updates;         // átadott periodikus adat frissítések
+  uint32_t unchanged;       // kihagyott minták (egyik mért mező sem változott)
+  uint32_t bytes_written;   // átírt bájtok összesen
+} padv_stats_t;
+
+// Boot után: set létrehozás, PHY/időzítés, periodikus + extended start.
+// false, ha ki van kapcsolva vagy a stack nem támogatja.
+bool padv_init(void);
+bool padv_is_active(void);
+
+// A mintából csak a változott bájtok íródnak át; adat a stacknek csak akkor
+// megy, ha volt változás (BLE task).
+sl_status_t padv_update(const telemetry_sample_t *s);
+
+void padv_get_stats(padv_stats_t *out);
@@ -0,0 +1,310 @@
+// -----------------------------------------------------------------------------
+// telemetry.c — Per-sample telemetry snapshot and its packed wire format
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Hold the latest sample (flow, pulses, duty, faults) with a sequence
+//     number and a timestamp, so every consumer sees one consistent record.
+//   • Decide per sample whether it is worth publishing (change-driven): flow
+//     moved by more than the deadband, the fault mask changed, or nothing was
+//     published for the heartbeat period. Sent/suppressed counts are kept so
+//     the airtime saving can be measured.
+//   • In streaming mode, accumulate samples into MTU-sized batches of
+//     timestamped records and hand a finished batch over to the BLE side when
+//     it is full or its oldest record reached the latency deadline.
+//   • Keep the last TELEMETRY_HISTORY_LEN published samples in a RAM ring for
+//     history download (command.c), walked by sequence number.
+//   • Serialize a sample into the fixed little-endian layout of the Telemetry
+//     characteristic (see telemetry.h), independent of compiler struct packing.
+//
+// Concurrency model & safety notes:
+//   • telemetry_record() runs in sleeptimer context (sample_cb), readers run in
+//     task context; the record is copied in/out inside a critical section.
+//   • Batches are double buffered: sample_cb fills s_fill, a finished batch is
+//     copied to s_ready, which the BLE task takes inside a critical section.
+//
+// -----------------------------------------------------------------------------
+
+#include "telemetry.h"
+#include "em_core.h"
+#include "sl_sleeptimer.h"
+
+// ---- Publishing parameters -------------------------------------------------------
+#define DEADBAND_X100_DEFAULT   5u       // 0.05 L/min
+#define HEARTBEAT_MS_DEFAULT    30000u   // at least one sample every 30 s
+
+// ---- Streaming parameters --------------------------------------------------------
+#define BATCH_PAYLOAD_DEFAULT   20u      // ATT_MTU 23 until the exchange completes
+#define BATCH_LATENCY_DEFAULT   1000u    // oldest record waits at most 1 s
+#define BATCH_LATENCY_MAX       60000u   // keeps dt_ms within 16 bits
+
+// ---- Internal State --------------------------------------------------------------
+static telemetry_sample_t s_latest;
+static uint16_t           s_seq = 0;
+
+// Last published sample, the reference for the deadband and the heartbeat
+static bool               s_have_published = false;
+static uint16_t           s_pub_flow_x100 = 0;
+static uint8_t            s_pub_faults = 0;
+static uint32_t           s_pub_ms = 0;
+
+static uint16_t           s_deadband_x100 = DEADBAND_X100_DEFAULT;
+static uint32_t           s_heartbeat_ms  = HEARTBEAT_MS_DEFAULT;
+static telemetry_stats_t  s_stats;
+
+// History of published samples (ring, s_hist_n valid entries ending at s_hist_pos-1)
+static telemetry_sample_t s_hist[TELEMETRY_HISTORY_LEN];
+static uint8_t            s_hist_pos = 0;
+static uint8_t            s_hist_n = 0;
+
+// Streaming batch buffers
+static bool               s_batch_on = false;
+static uint16_t           s_batch_payload = BATCH_PAYLOAD_DEFAULT;
+static uint16_t           s_batch_latency_ms = BATCH_LATENCY_DEFAULT;
+static uint8_t            s_fill[TELEMETRY_BATCH_MAX_LEN];
+static size_t             s_fill_len = 0;
+static uint8_t            s_fill_count = 0;
+static uint32_t           s_fill_base_ms = 0;
+static uint8_t            s_ready[TELEMETRY_BATCH_MAX_LEN];
+static size_t             s_ready_len = 0;
+static telemetry_batch_stats_t s_batch_stats;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+  return p + 4;
+}
+
+// Milliseconds since boot, wrapping after ~49 days.
+static uint32_t now_ms(void)
+{
+  uint64_t ms = 0;
+  (void)sl_sleeptimer_tick64_to_ms(sl_sleeptimer_get_tick_count64(), &ms);
+  return (uint32_t)ms;
+}
+
+// Change-driven publishing decision against the last published sample.
+static bool should_publish(const telemetry_sample_t *s)
+{
+  if (s_heartbeat_ms == 0 || !s_have_published) return true;
+  if (s->faults != s_pub_faults) return true;
+
+  uint16_t d = (s->flow_x100 > s_pub_flow_x100) ? (s->flow_x100 - s_pub_flow_x100)
+                                                : (s_pub_flow_x100 - s->flow_x100);
+  if (d > s_deadband_x100) return true;
+
+  return (s->timestamp_ms - s_pub_ms) >= s_heartbeat_ms;
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+bool telemetry_record(uint16_t flow_x100, uint32_t pulses,
+                      uint16_t duty_permille, uint8_t faults)
+{
+  telemetry_sample_t s;
+  s.seq           = s_seq++;
+  s.timestamp_ms  = now_ms();
+  s.flow_x100     = flow_x100;
+  s.pulses        = pulses;
+  s.duty_permille = duty_permille;
+  s.faults        = faults;
+
+  bool publish = should_publish(&s);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_latest = s;
+  if (publish) {
+    s_have_published = true;
+    s_pub_flow_x100  = s.flow_x100;
+    s_pub_faults     = s.faults;
+    s_pub_ms         = s.timestamp_ms;
+    s_stats.sent++;
+    s_hist[s_hist_pos] = s;
+    s_hist_pos = (uint8_t)((s_hist_pos + 1u) % TELEMETRY_HISTORY_LEN);
+    if (s_hist_n < TELEMETRY_HISTORY_LEN) s_hist_n++;
+  } else {
+    s_stats.suppressed++;
+  }
+  CORE_EXIT_CRITICAL();
+
+  return publish;
+}
+
+bool telemetry_history_start(uint8_t last_n, uint16_t *cursor)
+{
+  bool ok = false;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (s_hist_n != 0) {
+    if (last_n == 0 || last_n > s_hist_n) last_n = s_hist_n;
+    uint8_t i = (uint8_t)((s_hist_pos + TELEMETRY_HISTORY_LEN - last_n) % TELEMETRY_HISTORY_LEN);
+    *cursor = s_hist[i].seq;
+    ok = true;
+  }
+  CORE_EXIT_CRITICAL();
+  return ok;
+}
+
+bool telemetry_history_next(uint16_t *cursor, telemetry_sample_t *out)
+{
+  bool ok = false;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  // Oldest first: the first stored sample at or after the cursor. Samples
+  // overwritten meanwhile are skipped, not repeated.
+  for (uint8_t k = 0; k < s_hist_n; k++) {
+    uint8_t i = (uint8_t)((s_hist_pos + TELEMETRY_HISTORY_LEN - s_hist_n + k) % TELEMETRY_HISTORY_LEN);
+    if ((int16_t)(s_hist[i].seq - *cursor) >= 0) {
+      *out = s_hist[i];
+      *cursor = (uint16_t)(s_hist[i].seq + 1u);
+      ok = true;
+      break;
+    }
+  }
+  CORE_EXIT_CRITICAL();
+  return ok;
+}
+
+void telemetry_batch_enable(bool on)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_batch_on   = on;
+  s_fill_len   = 0;
+  s_fill_count = 0;
+  s_ready_len  = 0;
+  CORE_EXIT_CRITICAL();
+}
+bool telemetry_batch_is_enabled(void) { return s_batch_on; }
+
+void telemetry_batch_set_payload_max(uint16_t len)
+{
+  if (len > TELEMETRY_BATCH_MAX_LEN) len = TELEMETRY_BATCH_MAX_LEN;
+  if (len < TELEMETRY_BATCH_HDR_LEN + TELEMETRY_BATCH_REC_LEN) {
+    len = TELEMETRY_BATCH_HDR_LEN + TELEMETRY_BATCH_REC_LEN;
+  }
+  s_batch_payload = len;
+}
+
+void telemetry_batch_set_latency_ms(uint16_t ms)
+{
+  s_batch_latency_ms = (ms > BATCH_LATENCY_MAX) ? BATCH_LATENCY_MAX : ms;
+}
+
+bool telemetry_batch_append(void)
+{
+  if (!s_batch_on) return false;
+
+  const telemetry_sample_t *s = &s_latest;   // written by this context
+  if (s_fill_count == 0) {
+    s_fill_base_ms = s->timestamp_ms;
+    (void)put_u16(s_fill, s->seq);
+    (void)put_u32(s_fill + 2, s_fill_base_ms);
+    s_fill_len = TELEMETRY_BATCH_HDR_LEN;
+  }
+
+  uint32_t dt = s->timestamp_ms - s_fill_base_ms;
+  uint8_t *p = s_fill + s_fill_len;
+  p = put_u16(p, (uint16_t)dt);
+  p = put_u16(p, s->flow_x100);
+  *p++ = s->faults;
+  s_fill_len = (size_t)(p - s_fill);
+  s_fill_count++;
+
+  bool full = (s_fill_len + TELEMETRY_BATCH_REC_LEN) > s_batch_payload;
+  bool late = dt >= s_batch_latency_ms;
+  if (!full && !late) return false;
+
+  s_fill[6] = s_fill_count;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (s_ready_len != 0) s_batch_stats.overruns++;
+  for (size_t i = 0; i < s_fill_len; i++) s_ready[i] = s_fill[i];
+  s_ready_len = s_fill_len;
+  s_batch_stats.batches++;
+  s_batch_stats.records += s_fill_count;
+  CORE_EXIT_CRITICAL();
+
+  s_fill_len   = 0;
+  s_fill_count = 0;
+  return true;
+}
+
+void telemetry_batch_restart(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  s_fill_len   = 0;
+  s_fill_count = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+size_t telemetry_batch_take(uint8_t *buf, size_t max)
+{
+  size_t len = 0;
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (s_ready_len != 0 && s_ready_len <= max) {
+    for (size_t i = 0; i < s_ready_len; i++) buf[i] = s_ready[i];
+    len = s_ready_len;
+  }
+  s_ready_len = 0;
+  CORE_EXIT_CRITICAL();
+  return len;
+}
+
+void telemetry_batch_get_stats(telemetry_batch_stats_t *out)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = s_batch_stats;
+  CORE_EXIT_CRITICAL();
+}
+
+void telemetry_set_deadband_x100(uint16_t deadband) { s_deadband_x100 = deadband; }
+uint16_t telemetry_get_deadband_x100(void) { return s_deadband_x100; }
+
+void telemetry_set_heartbeat_ms(uint32_t ms) { s_heartbeat_ms = ms; }
+uint32_t telemetry_get_heartbeat_ms(void) { return s_heartbeat_ms; }
+
+void telemetry_get_stats(telemetry_stats_t *out)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = s_stats;
+  CORE_EXIT_CRITICAL();
+}
+
+void telemetry_get_latest(telemetry_sample_t *out)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *out = s_latest;
+  CORE_EXIT_CRITICAL();
+}
+
+size_t telemetry_pack(const telemetry_sample_t *s, uint8_t *buf)
+{
+  uint8_t *p = buf;
+  p = put_u16(p, s->seq);
+  p = put_u32(p, s->timestamp_ms);
+  p = put_u16(p, s->flow_x100);
+  p = put_u32(p, s->pulses);
+  p = put_u16(p, s->duty_permille);
+  *p++ = s->faults;
+  return (size_t)(p - buf);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Egy mintavétel pillanatképe (sample_cb tölti ki, a BLE oldal olvassa).
+typedef struct {
+  uint16_t seq;            // minta sorszám (körbefordul)
+  uint32_t timestamp_ms;   // indulás óta eltelt idő [ms]
+  uint16_t flow_x100;      // átfolyás [0.01 L/min]
+  uint32_t pulses;         // összes áramlásmérő impulzus
+  uint16_t duty_permille;  // PWM kitöltés [‰]
+  uint8_t  faults;         // HYDRO_ERR_* bitmaszk
+} telemetry_sample_t;
+
+// Csomagolt (little endian) forma hossza a Telemetry karakterisztikán:
+//   [0..1] seq  [2..5] timestamp_ms  [6..7] flow_x100  [8..11] pulses
+//   [12..13] duty_permille  [14] faults
+#define TELEMETRY_PACKED_LEN  15u
+
+// Publikálási statisztika (elküldött vs. elnyomott minták)
+typedef struct {
+  uint32_t sent;
+  uint32_t suppressed;
+} telemetry_stats_t;
+
+// Új minta rögzítése (sleeptimer kontextusból); seq és időbélyeg itt készül.
+// true, ha a mintát publikálni kell: az átfolyás a holtsávon túl változott,
+// a hibaállapot változott, vagy letelt a heartbeat idő az utolsó publikálás óta.
+bool telemetry_record(uint16_t flow_x100, uint32_t pulses,
+                      uint16_t duty_permille, uint8_t faults);
+
+// Holtsáv [0.01 L/min] és maximális csend [ms] (0 = minden minta publikált)
+void     telemetry_set_deadband_x100(uint16_t deadband);
+uint16_t telemetry_get_deadband_x100(void);
+void     telemetry_set_heartbeat_ms(uint32_t ms);
+uint32_t telemetry_get_heartbeat_ms(void);
+
+void telemetry_get_stats(telemetry_stats_t *out);
+
+// Legutóbbi minta másolata
+void telemetry_get_latest(telemetry_sample_t *out);
+
+// Minta csomagolása a fenti fix formátumba; visszatér a hosszal
+size_t telemetry_pack(const telemetry_sample_t *s, uint8_t *buf);
+
+// ---- History ----------------------------------------------------------------------
+// Az utolsó TELEMETRY_HISTORY_LEN publikált minta (RAM, újraindításig).
+#define TELEMETRY_HISTORY_LEN  32u
+
+// Letöltés kezdete: cursor az utolsó last_n (0 = mind) minta közül a legrégebbire.
+// false, ha nincs tárolt minta.
+bool telemetry_history_start(uint8_t last_n, uint16_t *cursor);
+// Következő minta a cursortól (legrégebbi elöl); false, ha nincs több.
+bool telemetry_history_next(uint16_t *cursor, telemetry_sample_t *out);
+
+// ---- Streaming (batch) ------------------------------------------------------------
+// Nagy mintavételi sebességnél a minták egy pufferbe gyűlnek, és egy MTU méretű
+// értesítésben mennek ki (Telemetry Stream karakterisztika), little endian:
+//   fejléc: seq_first (u16), base_timestamp_ms (u32), count (u8)
+//   rekord: dt_ms (u16, base-hez képest), flow_x100 (u16), faults (u8)
+#define TELEMETRY_BATCH_HDR_LEN   7u
+#define TELEMETRY_BATCH_REC_LEN   5u
+#define TELEMETRY_BATCH_MAX_LEN   244u   // ATT_MTU 247 - 3
+
+typedef struct {
+  uint32_t batches;     // kész batch-ek
+  uint32_t records;     // bennük lévő rekordok
+  uint32_t overruns;    // felülírt (el nem küldött) batch-ek
+} telemetry_batch_stats_t;
+
+void telemetry_batch_enable(bool on);
+bool telemetry_batch_is_enabled(void);
+// Maximális értesítés hossz (ATT_MTU - 3) és késleltetési határidő [ms]
+void telemetry_batch_set_payload_max(uint16_t len);
+void telemetry_batch_set_latency_ms(uint16_t ms);
+
+// A legutóbbi minta hozzáfűzése (sleeptimer kontextus, telemetry_record után).
+// true, ha egy batch elkészült (megtelt vagy lejárt a határidő).
+bool telemetry_batch_append(void);
+// A félkész batch eldobása, ha a mintavétel leállt vagy újraindul (a
+// rekordok időbélyege a batch első mintájához képest u16 ms)
+void telemetry_batch_restart(void);
+
+// Az elkészült batch kivétele (task kontextus); 0, ha nincs kész batch
+size_t telemetry_batch_take(uint8_t *buf, size_t max);
+
+void telemetry_batch_get_stats(telemetry_batch_stats_t *out);
@@ -0,0 +1,164 @@
+// -----------------------------------------------------------------------------
+// tlog.c — Tokenized binary log ring, drained from the idle loop
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Take TLOG() records (format string ID + raw integer arguments) from any
+//     context into a RAM ring, already in their wire layout (tlog.h), so a log
+//     call costs a short copy instead of a printf over a blocking USART.
+//   • Drain the ring into the logtx.c DMA ring from app_process_action(); the
+//     text is rebuilt on the host from the ELF (tools/tlog_decode.py). Each
+//     write holds whole records only, copied out across the ring wrap. A
+//     chunk logtx cannot take yet stays here and is not counted as a drop.
+//   • Never block a producer: a record that does not fit is dropped and
+//     counted, and the count is reported in-band with a TLOG_ID_DROPPED record.
+//
+// Concurrency model & safety notes:
+//   • tlog_put_() may run in IRQ or sleeptimer context. Only the space check
+//     and the head advance (the reservation) are inside the critical section;
+//     the record is written after it, so a nested producer may finish its
+//     record before the one it interrupted.
+//   • A record is published by its header byte, written last: the drain stops
+//     at the first header that is still 0 (reserved, not written yet) and
+//     zeroes the headers it consumed before moving the tail. TLOG_SYNC makes
+//     every written header non-zero.
+//   • Only the idle loop moves the tail. A chunk holds whole records and logtx
+//     takes every write as a whole or not at all, so app_log() text is never
+//     mixed into a record on the wire.
+//
+// Hardware assumptions:
+//   • Cortex-M33 stores words and halfwords to unaligned addresses (the args
+//     start at offset 3), so a record that does not wrap is written with one
+//     store per field; one that wraps falls back to bytes.
+//   • tlog_init() times one TLOG() with the DWT cycle counter and emits the
+//     result as a record (see tlog.h for the expected figure).
+//
+// -----------------------------------------------------------------------------
+
+#include "tlog.h"
+#include "em_core.h"
+#include "em_device.h"
+#include "logtx.h"
+#include <string.h>
+
+#define TLOG_HDR_LEN      3u
+#define TLOG_MASK         (TLOG_RING_SIZE - 1u)
+#define TLOG_DRAIN_CHUNK  128u   // per write; >= the longest record (19 bytes)
+
+// ---- Internal State --------------------------------------------------------------
+static uint8_t           s_ring[TLOG_RING_SIZE];
+static volatile uint32_t s_head = 0;          // free running, producers
+static volatile uint32_t s_tail = 0;          // free running, idle loop
+static volatile uint32_t s_dropped = 0;       // total since boot
+static uint32_t          s_dropped_reported = 0;
+
+// ---- Helper Functions ------------------------------------------------------------
+
+// Little-endian bytes of v at pos, across the ring wrap.
+static void ring_put_bytes(uint32_t pos, uint32_t v, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) {
+    s_ring[(pos + i) & TLOG_MASK] = (uint8_t)(v >> (8u * i));
+  }
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+bool tlog_put_(uint16_t id, uint8_t n, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+  uint32_t len = TLOG_HDR_LEN + 4u * n;
+
+  // Reserve: the only part that needs the critical section.
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  uint32_t head = s_head;
+  bool fits = (TLOG_RING_SIZE - (head - s_tail) >= len);
+  if (fits) {
+    s_head = head + len;
+  } else {
+    s_dropped++;
+  }
+  CORE_EXIT_CRITICAL();
+  if (!fits) return false;
+
+  uint32_t pos = head & TLOG_MASK;
+  if (pos + len <= TLOG_RING_SIZE) {
+    // Does not wrap: one (unaligned) store per field. The switch falls
+    // through from the last argument down.
+    uint8_t *p = &s_ring[pos];
+    switch (n) {
+      case 4: memcpy(p + TLOG_HDR_LEN + 12u, &d, 4u); // fall through
+      case 3: memcpy(p + TLOG_HDR_LEN + 8u,  &c, 4u); // fall through
+      case 2: memcpy(p + TLOG_HDR_LEN + 4u,  &b, 4u); // fall through
+      case 1: memcpy(p + TLOG_HDR_LEN,       &a, 4u); // fall through
+      default: break;
+    }
+    memcpy(p + 1, &id, 2u);
+  } else {
+    const uint32_t args[TLOG_MAX_ARGS] = { a, b, c, d };
+    for (uint8_t i = 0; i < n; i++) {
+      ring_put_bytes(head + TLOG_HDR_LEN + 4u * i, args[i], 4u);
+    }
+    ring_put_bytes(head + 1u, id, 2u);
+  }
+
+  // Publish: the header goes in after the rest of the record.
+  __DMB();
+  s_ring[pos] = (uint8_t)(TLOG_SYNC | n);
+  return true;
+}
+
+void tlog_init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  uint32_t t0 = DWT->CYCCNT;
+  TLOG("tlog: ring %u bytes, chunk %u, %u args, header %u\r\n",
+       TLOG_RING_SIZE, TLOG_DRAIN_CHUNK, TLOG_MAX_ARGS, TLOG_HDR_LEN);
+  uint32_t cycles = DWT->CYCCNT - t0;
+  TLOG("tlog: TLOG() with 4 args took %lu cycles\r\n", cycles);
+}
+
+void tlog_process(void)
+{
+  // Report drops first, once there is room for the record again.
+  uint32_t dropped = s_dropped;
+  if (dropped != s_dropped_reported
+      && tlog_put_(TLOG_ID_DROPPED, 1, dropped - s_dropped_reported, 0, 0, 0)) {
+    s_dropped_reported = dropped;
+  }
+
+  // Whole published records up to the head seen now, gathered into one
+  // linear chunk (a record may straddle the ring wrap); later records, and
+  // everything behind one still being written, wait for the next pass.
+  uint8_t chunk[TLOG_DRAIN_CHUNK];
+  uint32_t head = s_head;
+  while (s_tail != head) {
+    uint32_t len = 0;
+    while (s_tail + len != head) {
+      uint8_t hdr = *(volatile uint8_t *)&s_ring[(s_tail + len) & TLOG_MASK];
+      if (hdr == 0u) break;   // reserved, not published yet
+      __DMB();                // the body is read after its header
+      uint32_t rec = TLOG_HDR_LEN + 4u * (hdr & 0x0Fu);
+      if (len + rec > sizeof(chunk)) break;
+      for (uint32_t i = 0; i < rec; i++) {
+        chunk[len + i] = s_ring[(s_tail + len + i) & TLOG_MASK];
+      }
+      len += rec;
+    }
+    if (len == 0u || logtx_try_write(chunk, len) != SL_STATUS_OK) {
+      break;   // unpublished, or stream full: retried on the next pass
+    }
+    // Free the slots: headers back to 0 before the tail moves past them.
+    for (uint32_t off = 0; off < len; off += TLOG_HDR_LEN + 4u * (chunk[off] & 0x0Fu)) {
+      s_ring[(s_tail + off) & TLOG_MASK] = 0u;
+    }
+    s_tail += len;
+  }
+}
+
+uint32_t tlog_get_dropped(void)
+{
+  return s_dropped;
+}
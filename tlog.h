@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tokenizált bináris log a forró utakra (mintavétel, sink, értesítések). A
+// hívás helyén nincs formázás: a formátum string egy nem betöltött ELF
+// szekcióba (.tlog_fmt) kerül, a rekord csak a string azonosítóját (a
+// szekción belüli offset) és a nyers argumentumokat viszi egy RAM gyűrűbe.
+// A gyűrűt az idle loop (app_process_action) üríti a VCOM-ra; a szöveget a
+// host oldalon tools/tlog_decode.py állítja vissza a .axf fájlból.
+//
+// Költség (Cortex-M33, 4 argumentum): a kritikus szakaszban csak a hely
+// foglalása van (~12 ciklus), a mezők utána, egy-egy (nem igazított) tárolással
+// kerülnek a gyűrűbe. Az utasítássorból becsülve ~55 ciklus a hívással együtt
+// (a korábbi bájtonkénti másolás ~190, ebből ~120 a kritikus szakaszban).
+// A mért érték: a tlog_init() indításkor DWT ciklusszámlálóval méri, és
+// rekordként küldi ("tlog: TLOG() with 4 args took N cycles").
+//
+// Argumentumok: legfeljebb TLOG_MAX_ARGS egész (<= 32 bit), %s és %f nincs.
+// Tört értéket fixpontosan kell átadni (pl. átfolyás 0.01 L/min egységben).
+//
+// Rekord a vonalon (little endian), a szöveges app_log sorok közé ékelve:
+//   [0] TLOG_SYNC | n   (n = argumentumok száma; ASCII szövegben nem fordul elő)
+//   [1..2] formátum azonosító (.tlog_fmt offset), TLOG_ID_DROPPED: eldobott rekordok
+//   [3..] n * u32 argumentum
+
+#define TLOG_MAX_ARGS     4u
+#define TLOG_SYNC         0xF0u
+#define TLOG_ID_DROPPED   0xFFFFu   // 1 argumentum: eldobott rekordok száma
+#define TLOG_RING_SIZE    512u      // 2 hatványa
+
+// Nem allokált szekció: a '@' után az assembler a GCC által hozzáfűzött
+// "a" flaget kommentnek veszi, így a stringek nem foglalnak flasht.
+#define TLOG_FMT_SECTION  __attribute__((section(".tlog_fmt,\"\",%progbits @"), used))
+
+// TLOG("formátum", arg...) — bármely kontextusból hívható (IRQ, sleeptimer)
+#define TLOG(...)                                                             \
+  do {                                                                        \
+    static const char tlog_fmt_[] TLOG_FMT_SECTION = TLOG_FIRST_(__VA_ARGS__, 0); \
+    TLOG_CAT_(TLOG_EMIT_, TLOG_NARGS_(__VA_ARGS__))                           \
+      ((uint16_t)(uintptr_t)tlog_fmt_, __VA_ARGS__);                          \
+  } while (0)
+
+// DWT ciklusszámláló be, egy TLOG() hívás költségének mérése (app_init)
+void tlog_init(void);
+// Gyűrű ürítése a VCOM-ra (idle loop)
+void tlog_process(void);
+// Eldobott rekordok száma (teli gyűrű) indulás óta
+uint32_t tlog_get_dropped(void);
+
+// ---- belső ----
+// false, ha a gyűrű tele volt (a rekord eldobva)
+bool tlog_put_(uint16_t id, uint8_t n, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+
+#define TLOG_FIRST_(f, ...)  f
+#define TLOG_CAT_(a, b)      TLOG_CAT2_(a, b)
+#define TLOG_CAT2_(a, b)     a##b
+#define TLOG_NARGS_(...)     TLOG_NARGS2_(__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define TLOG_NARGS2_(_1, _2, _3, _4, _5, n, ...)  n
+#define TLOG_EMIT_1(id, f)                tlog_put_(id, 0, 0, 0, 0, 0)
+#define TLOG_EMIT_2(id, f, a)             tlog_put_(id, 1, (uint32_t)(a), 0, 0, 0)
+#define TLOG_EMIT_3(id, f, a, b)          tlog_put_(id, 2, (uint32_t)(a), (uint32_t)(b), 0, 0)
+#define TLOG_EMIT_4(id, f, a, b, c)       tlog_put_(id, 3, (uint32_t)(a), (uint32_t)(b), \
+                                                    (uint32_t)(c), 0)
+#define TLOG_EMIT_5(id, f, a, b, c, d)    tlog_put_(id, 4, (uint32_t)(a), (uint32_t)(b), \
+                                                    (uint32_t)(c), (uint32_t)(d))
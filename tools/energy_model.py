@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# energy_model.py — Host-side idle current model of the module (lowpower.h)
+# -----------------------------------------------------------------------------
+#
+# Estimates the average supply current while the pump is off and no client is
+# subscribed, for the profile before the low-power change (VCOM RX holding EM1,
+# thermal sampling at 1 Hz) and with the low-power profile (EM2 between
+# events, thermal sampler stopped). The activity that remains is the same in
+# both: connectable advertising at the slow stage, the periodic advertising
+# train and its extended advertising.
+#
+# The flow input (PC00) and the button (PC07) raise no edge interrupt in EM2;
+# in the profile they wake the core through their EM4WU interrupts instead,
+# so the EM2 floor holds as long as neither moves.
+#
+# Currents are EFR32BG22 datasheet typicals (3.0 V, DC-DC, 38.4 MHz HFXO) and
+# event durations are estimates; every value can be overridden, e.g.
+# --set em1_ua=900. With --stats the Energy Stats characteristic (energy.h)
+# read from a device is turned into an average current instead, so the model
+# can be checked against the measured EM residency.
+#
+# Usage:
+#   energy_model.py                      before/after table
+#   energy_model.py --set adv_ms=500     other advertising interval
+#   energy_model.py --stats 0a1b...      44-byte Energy Stats value (hex)
+# -----------------------------------------------------------------------------
+
+import argparse
+import struct
+import sys
+
+PARAMS = {
+    # Energy mode currents [uA]
+    "em0_ua": 1100.0,       # 27 uA/MHz at 38.4 MHz, flash, DC-DC
+    "em1_ua": 700.0,        # 17 uA/MHz plus HFXO and USART kept running
+    "em2_ua": 1.4,          # RTC on LFXO, full RAM retention
+    # Radio currents [uA]
+    "tx_ua": 10500.0,       # +8 dBm (SL_BT_CONFIG_MAX_TX_POWER), see txpwr.c
+    "rx_ua": 3600.0,        # 1M PHY
+    # Wakeup from EM2: HFXO start and clock restore [ms at em0_ua]
+    "wake_em2_ms": 0.35,
+    # Connectable legacy advertising (adv.c slow stage)
+    "adv_ms": 1000.0,       # interval
+    "adv_tx_ms": 0.38,      # ADV_IND, 47 bytes on air, per channel
+    "adv_rx_ms": 0.20,      # scan request window, per channel
+    "adv_cpu_ms": 0.9,      # stack work per event
+    # Periodic advertising train (padv.c)
+    "padv_ms": 1000.0,
+    "padv_tx_ms": 0.42,     # AUX_SYNC_IND with the 25 byte telemetry element
+    "padv_cpu_ms": 0.6,
+    "eadv_ms": 2000.0,      # extended advertising of the periodic set
+    "eadv_tx_ms": 0.75,     # 3 x ADV_EXT_IND + AUX_ADV_IND
+    "eadv_cpu_ms": 0.7,
+    # Thermal sampler (control.c thermal_cb, 1 Hz): IADC conversion + CPU
+    "thermal_ms": 1000.0,
+    "thermal_cpu_ms": 0.25,
+    "iadc_ua": 300.0,
+    "iadc_ms": 0.10,
+}
+
+STATS_FIELDS = ("uptime_ms", "em0_ms", "em1_ms", "em2_ms", "sleeps",
+                "wake_flow", "wake_button", "wake_radio", "wake_sleeptimer",
+                "wake_usart", "wake_other")
+
+
+def events(p, low_power):
+    """[(name, period_ms, active_ms, charge_uC)] of the idle activity."""
+    wake = p["wake_em2_ms"] if low_power else 0.0
+    ev = []
+
+    adv_active = 3 * (p["adv_tx_ms"] + p["adv_rx_ms"]) + p["adv_cpu_ms"] + wake
+    adv_q = (3 * (p["adv_tx_ms"] * p["tx_ua"] + p["adv_rx_ms"] * p["rx_ua"])
+             + (p["adv_cpu_ms"] + wake) * p["em0_ua"]) / 1000.0
+    ev.append(("legacy adv", p["adv_ms"], adv_active, adv_q))
+
+    padv_active = p["padv_tx_ms"] + p["padv_cpu_ms"] + wake
+    padv_q = (p["padv_tx_ms"] * p["tx_ua"] + (p["padv_cpu_ms"] + wake) * p["em0_ua"]) / 1000.0
+    ev.append(("periodic adv", p["padv_ms"], padv_active, padv_q))
+
+    eadv_active = p["eadv_tx_ms"] + p["eadv_cpu_ms"] + wake
+    eadv_q = (p["eadv_tx_ms"] * p["tx_ua"] + (p["eadv_cpu_ms"] + wake) * p["em0_ua"]) / 1000.0
+    ev.append(("extended adv", p["eadv_ms"], eadv_active, eadv_q))
+
+    if not low_power:
+        th_active = p["thermal_cpu_ms"] + p["iadc_ms"]
+        th_q = (p["thermal_cpu_ms"] * p["em0_ua"] + p["iadc_ms"] * (p["em1_ua"] + p["iadc_ua"])) / 1000.0
+        ev.append(("thermal sample", p["thermal_ms"], th_active, th_q))
+    return ev
+
+
+def profile(p, low_power):
+    """Average current [uA] per component, the sleep floor last."""
+    rows = []
+    active_frac = 0.0
+    for name, period, active, q in events(p, low_power):
+        rows.append((name, q * 1000.0 / period))
+        active_frac += active / period
+    floor = p["em2_ua"] if low_power else p["em1_ua"]
+    rows.append(("sleep floor (%s)" % ("EM2" if low_power else "EM1"),
+                 floor * max(0.0, 1.0 - active_frac)))
+    return rows
+
+
+def print_table(p, out):
+    before = dict(profile(p, False))
+    after = dict(profile(p, True))
+    names = list(before) + [n for n in after if n not in before]
+    out.write("%-22s %12s %12s\n" % ("component", "before [uA]", "after [uA]"))
+    for n in names:
+        b = before.get(n)
+        a = after.get(n)
+        out.write("%-22s %12s %12s\n" % (n, "-" if b is None else "%.2f" % b,
+                                         "-" if a is None else "%.2f" % a))
+    tb, ta = sum(before.values()), sum(after.values())
+    out.write("%-22s %12.2f %12.2f\n" % ("total", tb, ta))
+    out.write("reduction: %.1f x (%.1f %%), 220 mAh coin cell: %.0f h -> %.0f h\n" % (
+        tb / ta, 100.0 * (tb - ta) / tb, 220e3 / tb, 220e3 / ta))
+
+
+def from_stats(p, hexstr, out):
+    raw = bytes.fromhex(hexstr.replace(" ", "").replace(":", ""))
+    if len(raw) < 4 * len(STATS_FIELDS):
+        sys.exit("Energy Stats value needs %u bytes, got %u" % (4 * len(STATS_FIELDS), len(raw)))
+    s = dict(zip(STATS_FIELDS, struct.unpack_from("<%uI" % len(STATS_FIELDS), raw)))
+    total = s["em0_ms"] + s["em1_ms"] + s["em2_ms"]
+    if total == 0:
+        sys.exit("no residency recorded")
+    # Radio time is not part of the EM residency; charge every radio wakeup
+    # with the mean radio charge of the modelled advertising events.
+    radio = [
+        (1.0 / p["adv_ms"], 3 * (p["adv_tx_ms"] * p["tx_ua"] + p["adv_rx_ms"] * p["rx_ua"])),
+        (1.0 / p["padv_ms"], p["padv_tx_ms"] * p["tx_ua"]),
+        (1.0 / p["eadv_ms"], p["eadv_tx_ms"] * p["tx_ua"]),
+    ]
+    radio_q = sum(r * q for r, q in radio) / sum(r for r, _ in radio) / 1000.0
+    i_em = (s["em0_ms"] * p["em0_ua"] + s["em1_ms"] * p["em1_ua"]
+            + s["em2_ms"] * p["em2_ua"]) / total
+    i_radio = s["wake_radio"] * radio_q * 1000.0 / total
+    for k in STATS_FIELDS:
+        out.write("%-16s %10u\n" % (k, s[k]))
+    out.write("residency EM0/EM1/EM2: %.1f / %.1f / %.1f %%\n" % tuple(
+        100.0 * s[k] / total for k in ("em0_ms", "em1_ms", "em2_ms")))
+    out.write("average current: %.2f uA (modes %.2f + radio %.2f)\n" % (
+        i_em + i_radio, i_em, i_radio))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Idle current model, before/after the low-power profile.")
+    ap.add_argument("--set", action="append", default=[], metavar="NAME=VALUE",
+                    help="override a model parameter (see PARAMS)")
+    ap.add_argument("--stats", metavar="HEX", help="Energy Stats characteristic value")
+    ap.add_argument("--list", action="store_true", help="print the model parameters")
+    args = ap.parse_args()
+
+    p = dict(PARAMS)
+    for kv in args.set:
+        name, _, value = kv.partition("=")
+        if name not in p:
+            sys.exit("unknown parameter: %s" % name)
+        p[name] = float(value)
+
+    if args.list:
+        for k, v in p.items():
+            print("%-16s %g" % (k, v))
+    elif args.stats:
+        from_stats(p, args.stats, sys.stdout)
+    else:
+        print_table(p, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
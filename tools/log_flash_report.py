@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# log_flash_report.py — Flash cost of the compiled-in log levels (loglevel.h)
+# -----------------------------------------------------------------------------
+#
+# Input is the GNU ld map file of one build per LOG_BUILD_LEVEL (or per
+# LOG_BUILD_<MOD> override), e.g. built with -DLOG_BUILD_LEVEL=0 .. 5 and the
+# map file copied aside after each build. The first map is the reference; for
+# every further map the total flash use and the per object change are printed.
+#
+# Flash is everything the memory map places below RAM (.text, .rodata, the
+# tables) plus the load image of .data; debug and non-alloc sections such as
+# .tlog_fmt are not counted.
+#
+# Usage:
+#   log_flash_report.py debug.map info.map warning.map off.map [--top 15]
+# -----------------------------------------------------------------------------
+
+import argparse
+import os
+import re
+import sys
+from collections import defaultdict
+
+RAM_BASE = 0x20000000
+OUT_SEC = re.compile(r"^(\.\S+)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+))?")
+IN_SEC = re.compile(r"^ (\.\S+|COMMON)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*))?$")
+CONT = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$")
+LOAD = re.compile(r"load address (0x[0-9a-fA-F]+)")
+
+
+def short_name(path):
+    """'./app.o' -> 'app.o', 'lib.a(foo.o)' -> 'lib.a(foo.o)' without the directory."""
+    path = path.strip().replace("\\", "/")
+    m = re.match(r"(.*?)(\(.*\))$", path)
+    if m:
+        return os.path.basename(m.group(1)) + m.group(2)
+    return os.path.basename(path)
+
+
+def flash_by_object(path):
+    """Return {object: flash bytes} from the memory map part of a GNU ld map."""
+    sizes = defaultdict(int)
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            break
+    in_flash = False
+    pending = None                      # input section name wrapped onto next line
+    for line in lines:
+        m = OUT_SEC.match(line)
+        if m:
+            addr = m.group(2)
+            if addr is None:            # long output section name: values follow
+                nxt = next(lines, "")
+                parts = nxt.split()
+                if not parts or not parts[0].startswith("0x"):
+                    in_flash = False    # empty output section
+                    pending = None
+                    continue
+                addr = parts[0]
+                line = m.group(1) + " " + nxt
+            # .data lives in RAM but its initial image is stored in flash
+            in_flash = int(addr, 16) < RAM_BASE or LOAD.search(line) is not None
+            in_flash = in_flash and not m.group(1).startswith((".debug", ".comment",
+                                                               ".ARM.attributes", ".tlog_fmt",
+                                                               ".stack", ".heap", ".bss",
+                                                               ".noinit", ".nvm"))
+            pending = None
+            continue
+        if not in_flash:
+            continue
+        if pending:
+            c = CONT.match(line)
+            pending = None
+            if c:
+                sizes[short_name(c.group(3))] += int(c.group(2), 16)
+            continue
+        m = IN_SEC.match(line)
+        if not m or m.group(1).startswith("*"):
+            continue
+        if m.group(2) is None:
+            pending = m.group(1)
+            continue
+        sizes[short_name(m.group(4))] += int(m.group(3), 16)
+    return sizes
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Compare flash use of builds per log level.")
+    ap.add_argument("maps", nargs="+", help="map files, the first one is the reference")
+    ap.add_argument("--top", type=int, default=15, help="objects listed per comparison")
+    args = ap.parse_args()
+
+    ref_name = args.maps[0]
+    ref = flash_by_object(ref_name)
+    ref_total = sum(ref.values())
+    print("%-40s %8u bytes" % (ref_name, ref_total))
+    if len(args.maps) == 1:
+        for obj, size in sorted(ref.items(), key=lambda kv: -kv[1])[:args.top]:
+            print("  %-60s %8u" % (obj, size))
+        return
+
+    for name in args.maps[1:]:
+        cur = flash_by_object(name)
+        total = sum(cur.values())
+        print("%-40s %8u bytes  %+7d (%+.2f %%)" % (
+            name, total, total - ref_total, 100.0 * (total - ref_total) / ref_total))
+        deltas = [(obj, cur.get(obj, 0) - ref.get(obj, 0)) for obj in set(ref) | set(cur)]
+        deltas = [d for d in deltas if d[1]]
+        for obj, d in sorted(deltas, key=lambda kv: -abs(kv[1]))[:args.top]:
+            print("  %-60s %+8d" % (obj, d))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# swo_trace.py — Turn a captured SWO stream into an event timeline (trace.h)
+# -----------------------------------------------------------------------------
+#
+# Input is the raw SWO byte stream (ITM packets), e.g. saved by a J-Link SWO
+# viewer or Simplicity Commander. Events are 32-bit stimulus writes on ports
+# TRACE_PORT_BASE + type; their time comes from the ITM local timestamp
+# packets (CPU clock / prescaler) and is anchored to the sleeptimer ms value
+# of the TRACE_EV_TIME event sent with every sample. Port 0 carries text.
+#
+# Usage:
+#   swo_trace.py capture.swo [--cpu-hz 38400000] [--prescale 64] [--csv]
+#   swo_trace.py - < capture.swo
+# -----------------------------------------------------------------------------
+
+import argparse
+import sys
+
+TRACE_PORT_BASE = 8
+EV_PULSE, EV_SAMPLE, EV_NOTIFY, EV_FAULT, EV_ENABLE, EV_TIME = range(6)
+NAMES = ["pulse", "sample", "notify", "fault", "enable", "time"]
+
+FAULTS = {0x01: "dry_run", 0x02: "flow_while_off", 0x04: "stall", 0x08: "open_load"}  # HYDRO_ERR_*
+
+
+def fault_text(mask):
+    if mask == 0:
+        return "none"
+    names = [n for b, n in sorted(FAULTS.items()) if mask & b]
+    rest = mask & ~sum(FAULTS)
+    if rest:
+        names.append("0x%02x" % rest)
+    return "|".join(names)
+
+
+def describe(ev, v):
+    if ev == EV_PULSE:
+        return "pulses=%u" % v
+    if ev == EV_SAMPLE:
+        return "flow=%u.%02u L/min faults=%s%s" % (
+            (v & 0xFFFF) // 100, (v & 0xFFFF) % 100, fault_text((v >> 16) & 0xFF),
+            " published" if (v >> 24) & 1 else "")
+    if ev == EV_NOTIFY:
+        return "char=%u conn=%u sc=0x%02x" % (v >> 16, (v >> 8) & 0xFF, v & 0xFF)
+    if ev == EV_FAULT:
+        return "faults=%s" % fault_text(v)
+    if ev == EV_ENABLE:
+        return "%s duty=%u permille" % ("on" if v & 1 else "off", v >> 16)
+    if ev == EV_TIME:
+        return "sleeptimer=%u ms" % v
+    return "0x%08x" % v
+
+
+def packets(data):
+    """Yield ('sw', port, value) / ('ts', delta) / ('overflow',) from ITM bytes."""
+    i, n = 0, len(data)
+    while i < n:
+        h = data[i]
+        i += 1
+        if h == 0x00:                       # synchronization (zeros then 0x80)
+            while i < n and data[i] == 0x00:
+                i += 1
+            i += 1 if i < n and data[i] == 0x80 else 0
+        elif h == 0x70:
+            yield ("overflow",)
+        elif h & 0x0F == 0x00:              # local timestamp
+            if h & 0x80:
+                delta, shift = 0, 0
+                while i < n:
+                    b = data[i]
+                    i += 1
+                    delta |= (b & 0x7F) << shift
+                    shift += 7
+                    if not b & 0x80:
+                        break
+                yield ("ts", delta)
+            else:
+                yield ("ts", (h >> 4) & 0x07)
+        elif h & 0x0B == 0x08:              # extension: skip continuation bytes
+            while h & 0x80 and i < n:
+                h = data[i]
+                i += 1
+        elif h in (0x94, 0xB4):             # global timestamp: not used
+            while i < n:
+                b = data[i]
+                i += 1
+                if not b & 0x80:
+                    break
+        elif h & 0x03:                      # source packet
+            size = {1: 1, 2: 2, 3: 4}[h & 0x03]
+            payload = int.from_bytes(data[i:i + size], "little")
+            i += size
+            if not h & 0x04:                # instrumentation (software)
+                yield ("sw", h >> 3, payload)
+        # anything else is a stray byte; resynchronize on the next one
+
+
+def timeline(data, tick_s, out, csv):
+    cycles = 0                  # ITM timestamp ticks since capture start
+    anchor = None               # (ticks, ms) of the last TRACE_EV_TIME
+    pending = []                # events waiting for their timestamp packet
+    text = bytearray()
+    last_ms = None
+
+    def emit(ticks, ev, v):
+        nonlocal anchor, last_ms
+        if ev == EV_TIME:
+            anchor = (ticks, v)
+        t_ms = (anchor[1] + (ticks - anchor[0]) * tick_s * 1000.0) if anchor \
+            else ticks * tick_s * 1000.0
+        name = NAMES[ev] if ev < len(NAMES) else "port%d" % (ev + TRACE_PORT_BASE)
+        dt = "" if last_ms is None else "%+.3f" % (t_ms - last_ms)
+        last_ms = t_ms
+        if csv:
+            out.write("%.3f,%s,%u,%s\n" % (t_ms, name, v, describe(ev, v)))
+        else:
+            out.write("%12.3f ms %10s  %-7s %s\n" % (t_ms, dt, name, describe(ev, v)))
+
+    if csv:
+        out.write("time_ms,event,raw,detail\n")
+    for p in packets(data):
+        if p[0] == "ts":
+            cycles += p[1]
+            for ev, v in pending:
+                emit(cycles, ev, v)
+            pending.clear()
+        elif p[0] == "overflow":
+            out.write("# ITM overflow: events lost\n")
+        elif p[1] == 0:
+            text += (p[2] & 0xFF).to_bytes(1, "little")
+            if text.endswith(b"\n"):
+                out.write("# " + text.decode("latin-1").rstrip() + "\n")
+                text.clear()
+        elif p[1] >= TRACE_PORT_BASE:
+            pending.append((p[1] - TRACE_PORT_BASE, p[2]))
+    for ev, v in pending:       # no timestamp followed the last events
+        emit(cycles, ev, v)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode the SWO event trace.")
+    ap.add_argument("input", help="raw SWO capture, '-' for stdin")
+    ap.add_argument("--cpu-hz", type=float, default=38.4e6, help="core clock (HFXO 38.4 MHz)")
+    ap.add_argument("--prescale", type=int, default=64, choices=(1, 4, 16, 64),
+                    help="ITM timestamp prescaler (trace.c: 64)")
+    ap.add_argument("--csv", action="store_true")
+    args = ap.parse_args()
+
+    f = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    timeline(f.read(), args.prescale / args.cpu_hz, sys.stdout, args.csv)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,298 @@
+// -----------------------------------------------------------------------------
+// link_phy_test.c — Host test of link.c PHY / data length handling
+// -----------------------------------------------------------------------------
+//
+// Builds link.c on the host against the stubs in stubs/ and feeds it the
+// events sl_bt_on_event() forwards on a real link:
+//   • accepted: the central switches to 2M and 251 byte PDUs;
+//   • declined: the central answers with 1M and 27 bytes;
+//   • 1M fallback: the stack refuses the requests, or the central moves an
+//     established 2M link back to 1M.
+// Checks the commands link_opened() issues, the recorded link_params_t and
+// the 14-byte Link Parameters encoding (link.h), including the bulk
+// throughput field.
+//
+// Usage: make -C tools/test   (exit status 0 = all checks passed)
+// -----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include "link.h"
+#include "loglevel.h"
+#include "gatt_db.h"
+#include "sl_bluetooth.h"
+#include "sl_sleeptimer.h"
+#include "sl_debug_swo.h"
+
+// ---- Stubbed stack ---------------------------------------------------------------
+uint8_t g_log_level[LOG_MOD_COUNT] = {
+  APP_LOG_LEVEL_DEBUG, APP_LOG_LEVEL_DEBUG, APP_LOG_LEVEL_DEBUG, APP_LOG_LEVEL_DEBUG
+};
+
+static uint32_t s_tick = 0;                       // 1 tick = 1 ms
+static sl_status_t s_phy_sc = SL_STATUS_OK;       // set_preferred_phy result
+static sl_status_t s_dle_sc = SL_STATUS_OK;       // set_data_length result
+
+static struct {
+  uint32_t count;
+  uint8_t  connection, preferred, accepted;
+} s_phy_req;
+
+static struct {
+  uint32_t count;
+  uint8_t  connection;
+  uint16_t octets, time_us;
+} s_dle_req;
+
+uint32_t sl_sleeptimer_get_tick_count(void) { return s_tick; }
+uint32_t sl_sleeptimer_tick_to_ms(uint32_t tick) { return tick; }
+
+sl_status_t sl_sleeptimer_start_timer_ms(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout_ms,
+                                         sl_sleeptimer_timer_callback_t callback, void *data,
+                                         uint8_t priority, uint16_t option_flags)
+{
+  (void)handle; (void)timeout_ms; (void)callback; (void)data; (void)priority; (void)option_flags;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle)
+{
+  (void)handle;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_sleeptimer_is_timer_running(sl_sleeptimer_timer_handle_t *handle, bool *running)
+{
+  (void)handle;
+  *running = false;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_external_signal(uint32_t signals)
+{
+  (void)signals;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection, uint16_t min_interval,
+                                            uint16_t max_interval, uint16_t latency,
+                                            uint16_t timeout, uint16_t min_ce_length,
+                                            uint16_t max_ce_length)
+{
+  (void)connection; (void)min_interval; (void)max_interval; (void)latency;
+  (void)timeout; (void)min_ce_length; (void)max_ce_length;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection, uint8_t preferred_phy,
+                                               uint8_t accepted_phy)
+{
+  s_phy_req.count++;
+  s_phy_req.connection = connection;
+  s_phy_req.preferred = preferred_phy;
+  s_phy_req.accepted = accepted_phy;
+  return s_phy_sc;
+}
+
+sl_status_t sl_bt_connection_set_data_length(uint8_t connection, uint16_t tx_data_len,
+                                             uint16_t tx_time_us)
+{
+  s_dle_req.count++;
+  s_dle_req.connection = connection;
+  s_dle_req.octets = tx_data_len;
+  s_dle_req.time_us = tx_time_us;
+  return s_dle_sc;
+}
+
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic,
+                                                size_t value_len, const uint8_t *value)
+{
+  (void)connection; (void)characteristic; (void)value_len; (void)value;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_debug_swo_write_u32(uint32_t channel, uint32_t value)
+{
+  (void)channel; (void)value;
+  return SL_STATUS_OK;
+}
+
+// ---- Checks ----------------------------------------------------------------------
+static uint32_t s_checks = 0;
+static uint32_t s_failed = 0;
+
+#define CHECK_EQ(what, got, want)  check_eq(__LINE__, (what), (long)(got), (long)(want))
+
+static void check_eq(int line, const char *what, long got, long want)
+{
+  s_checks++;
+  if (got != want) {
+    s_failed++;
+    printf("FAIL line %d: %s = %ld, expected %ld\n", line, what, got, want);
+  }
+}
+
+static void open_link(uint8_t connection)
+{
+  memset(&s_phy_req, 0, sizeof(s_phy_req));
+  memset(&s_dle_req, 0, sizeof(s_dle_req));
+  link_opened(connection);
+}
+
+static link_params_t params_of(uint8_t connection)
+{
+  link_params_t p;
+  memset(&p, 0xA5, sizeof(p));
+  CHECK_EQ("link_get_params", link_get_params(connection, &p), true);
+  return p;
+}
+
+static void check_packed(const link_params_t *p, const uint8_t want[LINK_PARAMS_PACKED_LEN])
+{
+  uint8_t buf[LINK_PARAMS_PACKED_LEN + 1];
+  buf[LINK_PARAMS_PACKED_LEN] = 0x5A;   // guard: nothing written past the end
+  CHECK_EQ("packed length", link_pack_params(p, buf), LINK_PARAMS_PACKED_LEN);
+  for (uint32_t i = 0; i < LINK_PARAMS_PACKED_LEN; i++) {
+    char what[24];
+    snprintf(what, sizeof(what), "packed[%u]", (unsigned)i);
+    CHECK_EQ(what, buf[i], want[i]);
+  }
+  CHECK_EQ("packed guard", buf[LINK_PARAMS_PACKED_LEN], 0x5A);
+}
+
+// ---- Cases -----------------------------------------------------------------------
+
+static void test_requests_on_open(void)
+{
+  printf("requests on open\n");
+  open_link(1);
+  CHECK_EQ("phy requests", s_phy_req.count, 1);
+  CHECK_EQ("phy connection", s_phy_req.connection, 1);
+  CHECK_EQ("phy preferred", s_phy_req.preferred, sl_bt_gap_phy_2m);
+  CHECK_EQ("phy accepted", s_phy_req.accepted, sl_bt_gap_phy_1m | sl_bt_gap_phy_2m);
+  CHECK_EQ("dle requests", s_dle_req.count, 1);
+  CHECK_EQ("dle connection", s_dle_req.connection, 1);
+  CHECK_EQ("dle octets", s_dle_req.octets, 251);
+  CHECK_EQ("dle time", s_dle_req.time_us, 2120);
+
+  // Until the central answers, the link counts as 1M with 27 byte PDUs.
+  link_params_t p = params_of(1);
+  CHECK_EQ("initial phy", p.phy, sl_bt_gap_phy_1m);
+  CHECK_EQ("initial tx_octets", p.tx_octets, 27);
+  CHECK_EQ("initial throughput", p.throughput_bps, 0);
+  link_closed(1);
+}
+
+static void test_accepted(void)
+{
+  printf("accepted: 2M, 251 octets\n");
+  open_link(2);
+  link_params_updated(2, 24, 0, 400);
+  link_phy_updated(2, sl_bt_gap_phy_2m);
+  link_data_length_updated(2, 251);
+
+  link_params_t p = params_of(2);
+  CHECK_EQ("phy", p.phy, sl_bt_gap_phy_2m);
+  CHECK_EQ("tx_octets", p.tx_octets, 251);
+  CHECK_EQ("interval", p.interval, 24);
+  CHECK_EQ("timeout", p.timeout, 400);
+  const uint8_t want[LINK_PARAMS_PACKED_LEN] = {
+    24, 0,  0, 0,  0x90, 0x01,  LINK_PROFILE_NONE,  2,  251, 0,  0, 0, 0, 0
+  };
+  check_packed(&p, want);
+  link_closed(2);
+}
+
+static void test_declined(void)
+{
+  printf("declined: central keeps 1M, 27 octets\n");
+  open_link(3);
+  link_params_updated(3, 36, 4, 500);
+  link_phy_updated(3, sl_bt_gap_phy_1m);
+  link_data_length_updated(3, 27);
+
+  link_params_t p = params_of(3);
+  CHECK_EQ("phy", p.phy, sl_bt_gap_phy_1m);
+  CHECK_EQ("tx_octets", p.tx_octets, 27);
+  const uint8_t want[LINK_PARAMS_PACKED_LEN] = {
+    36, 0,  4, 0,  0xF4, 0x01,  LINK_PROFILE_NONE,  1,  27, 0,  0, 0, 0, 0
+  };
+  check_packed(&p, want);
+  link_closed(3);
+}
+
+static void test_fallback(void)
+{
+  printf("1M fallback: requests refused by the stack\n");
+  s_phy_sc = SL_STATUS_NOT_SUPPORTED;
+  s_dle_sc = SL_STATUS_INVALID_STATE;
+  open_link(4);
+  s_phy_sc = SL_STATUS_OK;
+  s_dle_sc = SL_STATUS_OK;
+  CHECK_EQ("phy requests", s_phy_req.count, 1);
+  CHECK_EQ("dle requests", s_dle_req.count, 1);
+
+  // The link is open and usable, recorded as 1M / 27.
+  link_params_t p = params_of(4);
+  CHECK_EQ("phy", p.phy, sl_bt_gap_phy_1m);
+  CHECK_EQ("tx_octets", p.tx_octets, 27);
+  link_closed(4);
+
+  printf("1M fallback: 2M link moved back to 1M\n");
+  open_link(5);
+  link_phy_updated(5, sl_bt_gap_phy_2m);
+  link_data_length_updated(5, 251);
+  link_phy_updated(5, sl_bt_gap_phy_1m);
+  p = params_of(5);
+  CHECK_EQ("phy", p.phy, sl_bt_gap_phy_1m);
+  CHECK_EQ("tx_octets", p.tx_octets, 251);   // data length is negotiated separately
+  link_closed(5);
+}
+
+static void test_bulk_throughput(void)
+{
+  printf("bulk throughput in the encoding\n");
+  open_link(6);
+  link_phy_updated(6, sl_bt_gap_phy_2m);
+  link_data_length_updated(6, 251);
+  link_set_subscribed(6, gattdb_telemetry_stream, true);
+
+  static const uint8_t chunk[200] = { 0 };
+  link_bulk_begin(6);
+  for (uint32_t i = 0; i < 30; i++) {
+    s_tick += 4;
+    CHECK_EQ("notify", link_notify(6, gattdb_telemetry_stream, sizeof(chunk), chunk), SL_STATUS_OK);
+  }
+  // 6000 bytes accepted over 120 ms = 50000 B/s
+  CHECK_EQ("link_bulk_end", link_bulk_end(6), 50000);
+  CHECK_EQ("second link_bulk_end", link_bulk_end(6), 0);
+
+  link_params_t p = params_of(6);
+  const uint8_t want[LINK_PARAMS_PACKED_LEN] = {
+    0, 0,  0, 0,  0, 0,  LINK_PROFILE_NONE,  2,  251, 0,  0x50, 0xC3, 0x00, 0x00
+  };
+  check_packed(&p, want);
+  link_closed(6);
+}
+
+static void test_unknown_connection(void)
+{
+  printf("events for an unknown connection\n");
+  link_phy_updated(9, sl_bt_gap_phy_2m);
+  link_data_length_updated(9, 251);
+  link_params_t p;
+  CHECK_EQ("link_get_params", link_get_params(9, &p), false);
+}
+
+int main(void)
+{
+  test_requests_on_open();
+  test_accepted();
+  test_declined();
+  test_fallback();
+  test_bulk_throughput();
+  test_unknown_connection();
+
+  printf("%lu checks, %lu failed\n", (unsigned long)s_checks, (unsigned long)s_failed);
+  return (s_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+// Host stub (tools/test): a naplót a teszt kimenetére írja
+#pragma once
+#include <stdio.h>
+#define APP_LOG_LEVEL_DEBUG     0
+#define APP_LOG_LEVEL_INFO      1
+#define APP_LOG_LEVEL_WARNING   2
+#define APP_LOG_LEVEL_ERROR     3
+#define APP_LOG_LEVEL_CRITICAL  4
+#define app_log_debug(...)    printf("  log: " __VA_ARGS__)
+#define app_log_info(...)     printf("  log: " __VA_ARGS__)
+#define app_log_warning(...)  printf("  log: " __VA_ARGS__)
+#define app_log_error(...)    printf("  log: " __VA_ARGS__)
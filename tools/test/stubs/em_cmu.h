@@ -0,0 +1,2 @@
+// Host stub (tools/test)
+#pragma once
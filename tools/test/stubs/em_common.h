@@ -0,0 +1,4 @@
+// Host stub (tools/test)
+#pragma once
+#include "sl_status.h"
+#define SL_WEAK __attribute__((weak))
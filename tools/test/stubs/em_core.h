@@ -0,0 +1,5 @@
+// Host stub (tools/test): egyszálú host, a kritikus szakasz üres
+#pragma once
+#define CORE_DECLARE_IRQ_STATE  int irqState = 0
+#define CORE_ENTER_CRITICAL()   (void)irqState
+#define CORE_EXIT_CRITICAL()
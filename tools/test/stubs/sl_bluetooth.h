@@ -0,0 +1,15 @@
+// Host stub (tools/test): a link.c által hívott BGAPI parancsok
+#pragma once
+#include "sl_status.h"
+enum { sl_bt_gap_phy_1m = 1, sl_bt_gap_phy_2m = 2, sl_bt_gap_phy_coded = 4 };
+sl_status_t sl_bt_external_signal(uint32_t signals);
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection, uint16_t min_interval,
+                                            uint16_t max_interval, uint16_t latency,
+                                            uint16_t timeout, uint16_t min_ce_length,
+                                            uint16_t max_ce_length);
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection, uint8_t preferred_phy,
+                                               uint8_t accepted_phy);
+sl_status_t sl_bt_connection_set_data_length(uint8_t connection, uint16_t tx_data_len,
+                                             uint16_t tx_time_us);
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic,
+                                                size_t value_len, const uint8_t *value);
@@ -0,0 +1,4 @@
+// Host stub (tools/test)
+#pragma once
+#include "sl_status.h"
+sl_status_t sl_debug_swo_write_u32(uint32_t channel, uint32_t value);
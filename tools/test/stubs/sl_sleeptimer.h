@@ -0,0 +1,12 @@
+// Host stub (tools/test): a tick 1 ms, a tesztből léptethető
+#pragma once
+#include "sl_status.h"
+typedef struct { int unused; } sl_sleeptimer_timer_handle_t;
+typedef void (*sl_sleeptimer_timer_callback_t)(sl_sleeptimer_timer_handle_t *handle, void *data);
+uint32_t    sl_sleeptimer_get_tick_count(void);
+uint32_t    sl_sleeptimer_tick_to_ms(uint32_t tick);
+sl_status_t sl_sleeptimer_start_timer_ms(sl_sleeptimer_timer_handle_t *handle, uint32_t timeout_ms,
+                                         sl_sleeptimer_timer_callback_t callback, void *data,
+                                         uint8_t priority, uint16_t option_flags);
+sl_status_t sl_sleeptimer_stop_timer(sl_sleeptimer_timer_handle_t *handle);
+sl_status_t sl_sleeptimer_is_timer_running(sl_sleeptimer_timer_handle_t *handle, bool *running);
@@ -0,0 +1,12 @@
+// Host stub (tools/test): a Gecko SDK sl_status.h részhalmaza
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+typedef uint32_t sl_status_t;
+#define SL_STATUS_OK                0x0000
+#define SL_STATUS_FAIL              0x0001
+#define SL_STATUS_INVALID_STATE     0x0002
+#define SL_STATUS_NOT_SUPPORTED     0x000F
+#define SL_STATUS_NO_MORE_RESOURCE  0x0019
+#define SL_STATUS_INVALID_PARAMETER 0x0021
@@ -0,0 +1,3 @@
+// Host stub (tools/test)
+#pragma once
+typedef struct { int unused; } sli_bt_gattdb_t;
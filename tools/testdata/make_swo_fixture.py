@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# make_swo_fixture.py — Synthesize the SWO test capture for swo_trace.py
+# -----------------------------------------------------------------------------
+#
+# Writes trace.swo: a raw ITM byte stream as the firmware (trace.h, trace.c)
+# and the SWO viewer would produce it, with every packet kind swo_trace.py
+# handles: synchronization, overflow, local timestamps (1-byte and
+# continuation forms), extension, global timestamp, hardware source packets,
+# port 0 text and 32-bit event writes on TRACE_PORT_BASE + type.
+# The expected decoder output is kept next to it (trace.txt, trace.csv);
+# tools/test/Makefile compares the two. Rerun this only when the capture
+# itself has to change, then regenerate and review the expected files.
+#
+# Usage: make_swo_fixture.py [out.swo]
+# -----------------------------------------------------------------------------
+
+import struct
+import sys
+
+TRACE_PORT_BASE = 8
+EV_PULSE, EV_SAMPLE, EV_NOTIFY, EV_FAULT, EV_ENABLE, EV_TIME = range(6)
+
+
+def sync():
+    return b"\x00" * 5 + b"\x80"
+
+
+def text(s):
+    """Port 0, one 8-bit stimulus write per character (sl_debug_swo printf)."""
+    return b"".join(bytes((0x01, c)) for c in s.encode("ascii"))
+
+
+def event(ev, value):
+    return bytes((((TRACE_PORT_BASE + ev) << 3) | 0x03,)) + struct.pack("<I", value)
+
+
+def ts(delta):
+    """Local timestamp: 1-byte form for 1..6, continuation form otherwise."""
+    if 1 <= delta <= 6:
+        return bytes((delta << 4,))
+    out = bytearray((0xC0,))            # C=1, TC=0 (in sync)
+    while True:
+        b = delta & 0x7F
+        delta >>= 7
+        out.append(b | (0x80 if delta else 0))
+        if not delta:
+            return bytes(out)
+
+
+def sample(flow_x100, faults, published):
+    return flow_x100 | (faults << 16) | ((1 if published else 0) << 24)
+
+
+def capture():
+    d = bytearray()
+    d += sync()
+    d += text("boot\n")
+    d += b"\x08"                        # extension, stimulus page 0, no continuation
+    d += event(EV_ENABLE, 1 | (350 << 16))
+    d += ts(5)
+    # One sample: time anchor, pulses, sample, notification
+    d += event(EV_TIME, 1000)
+    d += ts(600)                        # 1 ms at 38.4 MHz / 64
+    d += event(EV_PULSE, 42)
+    d += event(EV_SAMPLE, sample(1234, 0, True))
+    d += ts(130)
+    d += event(EV_NOTIFY, 0x00 | (1 << 8) | (30 << 16))
+    d += ts(3)
+    d += b"\x94\x81\x02"                # global timestamp 1, ignored
+    d += b"\x0e\x34\x12"                # hardware source (DWT), 2 bytes, ignored
+    # Next sample 100 ms later; a dry run is detected
+    d += event(EV_TIME, 1100)
+    d += ts(60000)
+    d += event(EV_SAMPLE, sample(5, 0x01, True))
+    d += event(EV_FAULT, 0x01)
+    d += ts(2)
+    d += text("dry run\n")
+    d += b"\x70"                        # overflow
+    d += b"\x88\x01"                    # extension with one continuation byte
+    d += event(EV_ENABLE, 0)
+    d += ts(4)
+    d += sync()
+    d += event(EV_NOTIFY, 0x19 | (2 << 8) | (33 << 16))   # no timestamp follows
+    return bytes(d)
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "trace.swo"
+    with open(path, "wb") as f:
+        f.write(capture())
+
+
+if __name__ == "__main__":
+    main()
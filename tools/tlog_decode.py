@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# tlog_decode.py — Rebuild tokenized log text (tlog.h) from the VCOM stream
+# -----------------------------------------------------------------------------
+#
+# The firmware writes TLOG() records between ordinary app_log() text lines:
+#   [0] 0xF0 | n   [1..2] format ID (offset in .tlog_fmt)   [3..] n * u32 LE
+# The format strings are not in flash; they are read here from the
+# non-allocated .tlog_fmt section of the ELF (ble_hydro_module.axf).
+#
+# Usage:
+#   tlog_decode.py ble_hydro_module.axf capture.bin
+#   tlog_decode.py ble_hydro_module.axf --serial /dev/ttyACM0 [--baud 115200]
+#   tlog_decode.py ble_hydro_module.axf -          (stdin)
+#
+# Only the standard library is needed; --serial needs pyserial.
+# -----------------------------------------------------------------------------
+
+import argparse
+import re
+import struct
+import sys
+
+TLOG_SYNC = 0xF0
+TLOG_MAX_ARGS = 4
+TLOG_ID_DROPPED = 0xFFFF
+FMT_SECTION = ".tlog_fmt"
+
+C_SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diuxXoc%])")
+
+
+def read_section(elf_path, name):
+    """Return (address, bytes) of an ELF32 little-endian section."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise SystemExit("%s: not a 32-bit little-endian ELF" % elf_path)
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def header(i):
+        # name, type, flags, addr, offset, size
+        return struct.unpack_from("<IIIIII", elf, shoff + i * shentsize)
+
+    strtab = header(shstrndx)
+    for i in range(shnum):
+        sh_name, _, _, addr, offset, size = header(i)
+        start = strtab[4] + sh_name
+        if elf[start:elf.index(b"\0", start)].decode() == name:
+            return addr, elf[offset:offset + size]
+    raise SystemExit("%s: no %s section (no TLOG() call linked in?)" % (elf_path, name))
+
+
+class Decoder:
+    def __init__(self, elf_path):
+        self.base, self.fmt = read_section(elf_path, FMT_SECTION)
+
+    def format_string(self, fmt_id):
+        off = (fmt_id - self.base) & 0xFFFF
+        if off >= len(self.fmt):
+            return None
+        end = self.fmt.find(b"\0", off)
+        return self.fmt[off:end if end >= 0 else len(self.fmt)].decode("latin-1")
+
+    def render(self, fmt_id, args):
+        if fmt_id == TLOG_ID_DROPPED:
+            return "<tlog: %u records dropped>\r\n" % args[0]
+        fmt = self.format_string(fmt_id)
+        if fmt is None:
+            return "<tlog: unknown format 0x%04x %s>\r\n" % (fmt_id, args)
+        values = iter(args)
+
+        def one(m):
+            flags, conv = m.group(1), m.group(2)
+            if conv == "%":
+                return "%"
+            v = next(values, 0)
+            if conv in "di":
+                v = v - (1 << 32) if v & 0x80000000 else v
+                conv = "d"
+            elif conv == "u":
+                conv = "d"
+            elif conv == "c":
+                return chr(v & 0xFF)
+            return ("%" + flags + conv) % v
+
+        return C_SPEC.sub(one, fmt)
+
+    def feed(self, data, out):
+        """Decode as much of data as possible; return the unused tail."""
+        i = 0
+        text = bytearray()
+        while i < len(data):
+            b = data[i]
+            n = b & 0x0F
+            if (b & 0xF0) != TLOG_SYNC or n > TLOG_MAX_ARGS:
+                text.append(b)
+                i += 1
+                continue
+            need = 3 + 4 * n
+            if len(data) - i < need:
+                break
+            if text:
+                out.write(text.decode("latin-1"))
+                text.clear()
+            fmt_id, = struct.unpack_from("<H", data, i + 1)
+            args = struct.unpack_from("<%dI" % n, data, i + 3)
+            out.write(self.render(fmt_id, args))
+            i += need
+        if text:
+            out.write(text.decode("latin-1"))
+        out.flush()
+        return data[i:]
+
+
+def chunks(args):
+    if args.serial:
+        import serial  # pyserial
+        port = serial.Serial(args.serial, args.baud, timeout=0.1)
+        while True:
+            yield port.read(256)
+    f = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    while True:
+        block = f.read(4096)
+        if not block:
+            return
+        yield block
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode tokenized TLOG records.")
+    ap.add_argument("elf", help="firmware image with symbols (ble_hydro_module.axf)")
+    ap.add_argument("input", nargs="?", default="-", help="captured stream, '-' for stdin")
+    ap.add_argument("--serial", help="read live from this serial port instead")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    dec = Decoder(args.elf)
+    pending = b""
+    try:
+        for block in chunks(args):
+            pending = dec.feed(pending + block, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+    if pending:
+        sys.stdout.write("<tlog: %d trailing bytes of a cut record>\n" % len(pending))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+// -----------------------------------------------------------------------------
+// trace.c — SWO/ITM event trace setup
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Enable one ITM stimulus port per event type (trace.h) on top of the SWO
+//     output that sl_debug_swo_init() already configured.
+//   • Turn on the ITM local timestamps, so every event gets its time from the
+//     trace hardware instead of a clock read at the call site.
+//
+// Concurrency model & safety notes:
+//   • TRACE() may be used from any context: a stimulus write is a single word
+//     store, and the ITM serializes packets from all ports itself.
+//   • Without a debugger collecting SWO the FIFO drains into nothing; a write
+//     only waits when the FIFO is full, which at 875 kHz SWO takes a burst of
+//     events far above the pulse and sample rates here.
+//
+// -----------------------------------------------------------------------------
+
+#include "trace.h"
+#include "em_device.h"
+
+// ITM_TCR.TSPrescale: local timestamp counter = CPU clock / 64
+#define TRACE_TS_PRESCALE_64  3u
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void trace_init(void)
+{
+#if TRACE_ENABLE
+  for (uint32_t ev = 0; ev < TRACE_EV_COUNT; ev++) {
+    (void)sl_debug_swo_enable_itm(TRACE_PORT_BASE + ev);
+  }
+  ITM->TCR = (ITM->TCR & ~ITM_TCR_TSPrescale_Msk)
+             | (TRACE_TS_PRESCALE_64 << ITM_TCR_TSPrescale_Pos)
+             | ITM_TCR_TSENA_Msk;
+#endif
+}
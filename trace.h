@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// SWO/ITM esemény trace: egy esemény = egy 32 bites ITM stimulus írás a
+// típushoz tartozó portra (néhány ciklus, formázás nélkül). Az időbélyeget az
+// ITM hardver teszi mellé (local timestamp csomag, CPU órajel / 64), a
+// mintánkénti TRACE_EV_TIME a sleeptimer ms értékével horgonyozza az idővonalat
+// (EM2-ben az ITM időbélyeg számláló áll). Host: tools/swo_trace.py.
+// 0: a TRACE() hívások nem fordulnak be.
+#define TRACE_ENABLE        1
+
+#define TRACE_PORT_BASE     8u     // 0: sl_debug_swo szöveg (printf)
+
+// Esemény típusok (port = TRACE_PORT_BASE + típus) és 32 bites argumentumuk
+#define TRACE_EV_PULSE      0u     // összes impulzus
+#define TRACE_EV_SAMPLE     1u     // flow_x100 | faults << 16 | publikálva << 24
+#define TRACE_EV_NOTIFY     2u     // status (low byte) | connection << 8 | karakterisztika << 16
+#define TRACE_EV_FAULT      3u     // új HYDRO_ERR_* maszk
+#define TRACE_EV_ENABLE     4u     // be/ki | duty_permille << 16
+#define TRACE_EV_TIME       5u     // sleeptimer idő [ms] (horgony)
+#define TRACE_EV_COUNT      6u
+
+// Boot után (sl_debug_swo_init már lefutott): portok engedélyezése, ITM
+// local timestamp bekapcsolás
+void trace_init(void);
+
+#if TRACE_ENABLE
+#include "sl_debug_swo.h"
+#define TRACE(ev, arg)  ((void)sl_debug_swo_write_u32(TRACE_PORT_BASE + (ev), (uint32_t)(arg)))
+#else
+#define TRACE(ev, arg)  ((void)0)
+#endif
@@ -0,0 +1,300 @@
+// -----------------------------------------------------------------------------
+// txpwr.c — Per-connection TX power with LE Power Control
+// -----------------------------------------------------------------------------
+//
+// Responsibilities of this module:
+//   • Keep every advertising set at SL_BT_CONFIG_MAX_TX_POWER with
+//     sl_bt_advertiser_set_tx_power(), so the connectable, BTHome and periodic
+//     adverts are heard from the full range whatever the links run at.
+//   • Leave the TX power of each connection to LE Power Control
+//     (bluetooth_feature_power_control). The stack changes the level of one
+//     connection at a time, within SL_BT_CONFIG_MIN/MAX_TX_POWER, when that
+//     central asks for it from its golden RSSI range; in turn it asks the
+//     central to keep our RSSI inside our golden range (slcp configuration).
+//     A central without power control leaves its link at full power.
+//   • Enable power reporting on every connection and record the level the
+//     stack reports for it (sl_bt_evt_connection_tx_power).
+//   • Poll the RSSI of every open connection once per TXPWR_POLL_MS and keep a
+//     smoothed value per link. With the central's TX power assumed and the
+//     link taken as reciprocal, it gives the level arriving at the central;
+//     a link whose headroom above TXPWR_SENSITIVITY_DBM drops below the
+//     configured warning threshold is logged and counted. The threshold does
+//     not change any TX power.
+//   • Report the average TX power of the links, the level changes the
+//     central requested, and the radio TX energy those saved against running
+//     every link at SL_BT_CONFIG_MAX_TX_POWER.
+//
+// Concurrency model & safety notes:
+//   • poll_cb() (sleeptimer) only raises SIG_TXPWR; every stack call happens in
+//     BLE task context (txpwr_process(), txpwr_rssi(), open/close).
+//   • The system-wide sl_bt_system_set_tx_power() must not be used while
+//     advertising or connected, and is not called at all; the range it would
+//     set comes from SL_BT_CONFIG_MIN/MAX_TX_POWER at stack init.
+//
+// Watch outs / TODOs:
+//   • There is no device-side TX power loop: the stack offers no way to set
+//     the level of one connection, and this device always advertises, so
+//     sl_bt_system_set_tx_power() never gets a window. A central without
+//     power control keeps its link at SL_BT_CONFIG_MAX_TX_POWER.
+//
+// -----------------------------------------------------------------------------
+
+#include "txpwr.h"
+#include "app.h"
+#include "app_log.h"
+#include "loglevel.h"
+#include "sl_bluetooth.h"
+#include "sl_bluetooth_config.h"
+#include "sl_bluetooth_connection_config.h"
+#include "sl_sleeptimer.h"
+
+#define TXPWR_SENSITIVITY_DBM   (-90)   // usable level at the central (1M/2M)
+#define TXPWR_PEER_TX_DBM       0       // assumed TX power of the central
+#define TXPWR_DROP_DB           6       // RSSI below the average by this: restart
+#define TXPWR_LOG_POLLS         60u     // stats log period [polls]
+
+// sl_bt_evt_connection_tx_power: power_level values that are not a level
+#define TXPWR_LEVEL_NOT_MANAGED 126
+#define TXPWR_LEVEL_UNAVAILABLE 127
+
+#define TXPWR_NO_CONNECTION     0xFFu
+
+// ---- Internal State --------------------------------------------------------------
+typedef struct {
+  uint8_t connection;    // TXPWR_NO_CONNECTION: free slot
+  bool    have_rssi;
+  bool    under_warn;    // headroom below the threshold at the last poll
+  int16_t rssi_x16;      // smoothed RSSI [1/16 dB]
+  int16_t level_x10;     // TX power the stack reported [0.1 dBm]
+} txpwr_link_t;
+
+static txpwr_link_t s_links[SL_BT_CONFIG_MAX_CONNECTIONS];
+static uint8_t  s_open = 0;
+static uint8_t  s_warn_db = TXPWR_WARN_DB_DEFAULT;
+static sl_sleeptimer_timer_handle_t s_poll_tmr;
+
+// Statistics, accumulated once per poll and link while connected
+static int32_t  s_level_sum_x10;
+static uint32_t s_samples;
+static uint32_t s_ma_sum_x10;       // modelled TX current at the level used
+static uint32_t s_ma_max_sum_x10;   // ... and at full power
+static uint32_t s_pc_steps_down;    // level changes the central requested
+static uint32_t s_pc_steps_up;
+static uint32_t s_under_warn;
+static uint32_t s_polls;
+
+// Radio TX current against output power (EFR32BG22 datasheet, 3 V, DC-DC),
+// linearly interpolated; only the ratio is used for the saving estimate.
+static const struct { int16_t dbm_x10; uint16_t ma_x10; } s_tx_current[] = {
+  { -300, 28 }, { -100, 33 }, { 0, 41 }, { 30, 55 }, { 60, 82 }, { 80, 105 },
+};
+#define TXPWR_CURRENT_POINTS  (sizeof(s_tx_current) / sizeof(s_tx_current[0]))
+
+// ---- Helper Functions ------------------------------------------------------------
+
+static void poll_cb(sl_sleeptimer_timer_handle_t *handle, void *data)
+{
+  (void)handle; (void)data;
+  (void)sl_bt_external_signal(SIG_TXPWR);
+}
+
+static txpwr_link_t *find(uint8_t connection)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    if (s_links[i].connection == connection) return &s_links[i];
+  }
+  return NULL;
+}
+
+static uint32_t tx_current_x10(int16_t dbm_x10)
+{
+  if (dbm_x10 <= s_tx_current[0].dbm_x10) return s_tx_current[0].ma_x10;
+  for (uint32_t i = 1; i < TXPWR_CURRENT_POINTS; i++) {
+    if (dbm_x10 <= s_tx_current[i].dbm_x10) {
+      int32_t x0 = s_tx_current[i - 1u].dbm_x10, x1 = s_tx_current[i].dbm_x10;
+      int32_t y0 = s_tx_current[i - 1u].ma_x10,  y1 = s_tx_current[i].ma_x10;
+      return (uint32_t)(y0 + (y1 - y0) * (dbm_x10 - x0) / (x1 - x0));
+    }
+  }
+  return s_tx_current[TXPWR_CURRENT_POINTS - 1u].ma_x10;
+}
+
+// Level arriving at the central above its sensitivity [dB], from our TX power
+// and the path loss seen in the other direction.
+static int32_t headroom_db(const txpwr_link_t *l)
+{
+  int32_t loss_x10 = TXPWR_PEER_TX_DBM * 10 - (l->rssi_x16 * 10) / 16;
+  return (l->level_x10 - loss_x10) / 10 - TXPWR_SENSITIVITY_DBM;
+}
+
+static void check_headroom(txpwr_link_t *l)
+{
+  bool under = headroom_db(l) < (int32_t)s_warn_db;
+  if (under && !l->under_warn) {
+    s_under_warn++;
+    LOG_WARN(POWER, "Link %u: TX %d [0.1 dBm] leaves %ld dB at the central (warn %u)\r\n",
+                    (unsigned)l->connection, (int)l->level_x10,
+                    (long)headroom_db(l), (unsigned)s_warn_db);
+  }
+  l->under_warn = under;
+}
+
+static void accumulate(void)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    const txpwr_link_t *l = &s_links[i];
+    if (l->connection == TXPWR_NO_CONNECTION) continue;
+    s_level_sum_x10 += l->level_x10;
+    s_ma_sum_x10 += tx_current_x10(l->level_x10);
+    s_ma_max_sum_x10 += tx_current_x10(SL_BT_CONFIG_MAX_TX_POWER);
+    s_samples++;
+  }
+
+  if ((++s_polls % TXPWR_LOG_POLLS) == 0) {
+    txpwr_stats_t st;
+    txpwr_get_stats(&st);
+    LOG_INFO(POWER, "TX power %d, avg %d [0.1 dBm], rssi %d dBm, "
+                    "central power control saved %u permille\r\n",
+                    (int)st.level_x10, (int)st.avg_level_x10, (int)st.rssi_avg,
+                    (unsigned)st.pc_saved_permille);
+  }
+}
+
+// ---- PUBLIC ----------------------------------------------------------------------
+
+void txpwr_init(void)
+{
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    s_links[i].connection = TXPWR_NO_CONNECTION;
+  }
+  s_open = 0;
+}
+
+sl_status_t txpwr_advertiser_init(uint8_t handle)
+{
+  int16_t set_power;
+  sl_status_t sc = sl_bt_advertiser_set_tx_power(handle, SL_BT_CONFIG_MAX_TX_POWER, &set_power);
+  if (sc == SL_STATUS_OK) {
+    LOG_DEBUG(POWER, "Advertiser %u: TX power %d [0.1 dBm]\r\n", (unsigned)handle, (int)set_power);
+  } else {
+    LOG_ERROR(POWER, "Advertiser %u: TX power failed sc=0x%04lx\r\n",
+                     (unsigned)handle, (unsigned long)sc);
+  }
+  return sc;
+}
+
+void txpwr_opened(uint8_t connection)
+{
+  txpwr_link_t *l = find(TXPWR_NO_CONNECTION);
+  if (l == NULL) return;
+  l->connection = connection;
+  l->have_rssi = false;
+  l->under_warn = false;
+  // Connections start at full power; power control lowers them from there.
+  l->level_x10 = SL_BT_CONFIG_MAX_TX_POWER;
+
+  sl_status_t sc = sl_bt_connection_set_power_reporting(connection,
+                                                        sl_bt_connection_power_reporting_enable);
+  if (sc != SL_STATUS_OK) {
+    LOG_WARN(POWER, "Link %u: power reporting failed sc=0x%04lx\r\n",
+                    (unsigned)connection, (unsigned long)sc);
+  }
+  if (s_open++ == 0) {
+    (void)sl_sleeptimer_start_periodic_timer_ms(&s_poll_tmr, TXPWR_POLL_MS,
+                                                poll_cb, NULL, 0, 0);
+  }
+}
+
+void txpwr_closed(uint8_t connection)
+{
+  txpwr_link_t *l = find(connection);
+  if (l == NULL) return;
+  l->connection = TXPWR_NO_CONNECTION;
+
+  if (--s_open == 0) {
+    (void)sl_sleeptimer_stop_timer(&s_poll_tmr);
+  }
+}
+
+void txpwr_level(uint8_t connection, int8_t power_level)
+{
+  txpwr_link_t *l = find(connection);
+  if (l == NULL) return;
+  if (power_level == TXPWR_LEVEL_NOT_MANAGED || power_level == TXPWR_LEVEL_UNAVAILABLE) return;
+
+  int16_t x10 = (int16_t)(power_level * 10);
+  if (x10 < l->level_x10) {
+    s_pc_steps_down++;
+  } else if (x10 > l->level_x10) {
+    s_pc_steps_up++;
+  }
+  LOG_DEBUG(POWER, "Link %u: TX power %d dBm\r\n", (unsigned)connection, (int)power_level);
+  l->level_x10 = x10;
+}
+
+void txpwr_rssi(uint8_t connection, uint8_t status, int8_t rssi)
+{
+  txpwr_link_t *l = find(connection);
+  if (l == NULL || status != 0) return;
+
+  int16_t x16 = (int16_t)(rssi * 16);
+  if (!l->have_rssi || rssi * 16 < l->rssi_x16 - TXPWR_DROP_DB * 16) {
+    // First value or a sudden fade: restart the average from the new level.
+    l->rssi_x16 = x16;
+  } else {
+    l->rssi_x16 = (int16_t)(l->rssi_x16 + (x16 - l->rssi_x16) / 4);
+  }
+  l->have_rssi = true;
+  check_headroom(l);
+}
+
+void txpwr_process(void)
+{
+  if (s_open == 0) return;
+
+  accumulate();
+
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    uint8_t conn = s_links[i].connection;
+    if (conn == TXPWR_NO_CONNECTION) continue;
+    (void)sl_bt_connection_get_rssi(conn);
+  }
+}
+
+bool txpwr_set_warn_db(uint8_t db)
+{
+  if (db > TXPWR_WARN_DB_MAX) return false;
+  s_warn_db = db;
+  return true;
+}
+
+uint8_t txpwr_get_warn_db(void)
+{
+  return s_warn_db;
+}
+
+void txpwr_get_stats(txpwr_stats_t *out)
+{
+  int16_t weakest = INT16_MAX;
+  int16_t level = SL_BT_CONFIG_MAX_TX_POWER;
+  bool any = false;
+  for (uint32_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++) {
+    const txpwr_link_t *l = &s_links[i];
+    if (l->connection == TXPWR_NO_CONNECTION) continue;
+    if (!any || l->level_x10 > level) level = l->level_x10;
+    any = true;
+    if (l->have_rssi && l->rssi_x16 < weakest) weakest = l->rssi_x16;
+  }
+
+  out->level_x10      = level;
+  out->avg_level_x10  = (s_samples != 0) ? (int16_t)(s_level_sum_x10 / (int32_t)s_samples)
+                                         : SL_BT_CONFIG_MAX_TX_POWER;
+  out->rssi_avg       = (weakest != INT16_MAX) ? (int8_t)(weakest / 16) : 0;
+  out->pc_saved_permille = (s_ma_max_sum_x10 != 0)
+                           ? (uint16_t)(1000u - (uint32_t)((uint64_t)s_ma_sum_x10 * 1000u
+                                                           / s_ma_max_sum_x10))
+                           : 0;
+  out->pc_steps_down     = s_pc_steps_down;
+  out->pc_steps_up       = s_pc_steps_up;
+  out->under_warn        = s_under_warn;
+}
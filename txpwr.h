@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_status.h"
+
+// TX teljesítmény: a hirdetések mindig SL_BT_CONFIG_MAX_TX_POWER szinten
+// mennek (halmazonként beállítva), a kapcsolatok szintjét az LE Power Control
+// állítja kapcsolatonként (a central golden RSSI tartománya szerint, a
+// SL_BT_CONFIG_MIN/MAX_TX_POWER határok között). A modul a jelentett szintet
+// és az RSSI-t követi; ha a centralhoz érkező becsült szint a figyelmeztetési
+// küszöbnél közelebb kerül az érzékenységhez, naplóz és számol.
+// Korlát: a készülék a saját kapcsolati TX szintjét nem szabályozza. A stack
+// kapcsolatonként csak a central kérésére vált szintet, a rendszerszintű
+// sl_bt_system_set_tx_power() pedig hirdetés vagy kapcsolat alatt nem
+// használható (itt mindig van hirdetés). Power Control nélküli centralnál a
+// kapcsolat SL_BT_CONFIG_MAX_TX_POWER szinten marad; a küszöb ezen nem
+// változtat, a megtakarítás és a lépések a central szabályozásának eredménye.
+
+#define TXPWR_POLL_MS           1000u
+#define TXPWR_WARN_DB_DEFAULT   15u
+#define TXPWR_WARN_DB_MAX       40u
+
+typedef struct {
+  int16_t  level_x10;        // kapcsolatok legnagyobb jelenlegi szintje [0.1 dBm]
+  int16_t  avg_level_x10;    // kapcsolatok átlagos szintje [0.1 dBm]
+  int8_t   rssi_avg;         // leggyengébb kapcsolat átlagolt RSSI [dBm]
+  uint16_t pc_saved_permille; // a central Power Control kéréseivel elért
+                               // becsült TX rádió energia megtakarítás [‰]
+  uint32_t pc_steps_down;      // a central kérésére lejjebb / feljebb lépett
+  uint32_t pc_steps_up;
+  uint32_t under_warn;         // kapcsolat a küszöb alá került (esetek)
+} txpwr_stats_t;
+
+void txpwr_init(void);
+// Hirdetési halmaz teljes teljesítményre (létrehozás után, indítás előtt)
+sl_status_t txpwr_advertiser_init(uint8_t handle);
+// Kapcsolat életciklus (BLE task)
+void txpwr_opened(uint8_t connection);
+void txpwr_closed(uint8_t connection);
+// sl_bt_evt_connection_tx_power: a stack által beállított szint [dBm]
+void txpwr_level(uint8_t connection, int8_t power_level);
+// sl_bt_evt_connection_rssi eredménye
+void txpwr_rssi(uint8_t connection, uint8_t status, int8_t rssi);
+// RSSI lekérdezés minden kapcsolaton (BLE task, SIG_TXPWR jelre)
+void txpwr_process(void);
+
+// Figyelmeztetési küszöb: becsült szint a central érzékenysége felett [dB]
+// (0..TXPWR_WARN_DB_MAX); false, ha érvénytelen. Csak naplóz, a TX szintet
+// nem állítja.
+bool    txpwr_set_warn_db(uint8_t db);
+uint8_t txpwr_get_warn_db(void);
+
+void txpwr_get_stats(txpwr_stats_t *out);